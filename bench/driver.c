@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Query latency driver for "make bench".
+ *
+ * Runs pkg-config over a tree made by pcgen: every query type is run a
+ * number of times, cycling through the root packages of the tree, and the
+ * distribution of the wall clock time per query is printed as JSON along
+ * with the CPU time and the peak RSS of the runs. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <glib.h>
+
+
+typedef struct
+{
+  const char *name;
+  const char *args[3];          /* the package goes last */
+  gboolean with_package;
+} Query;
+
+static const Query queries[] = {
+  { "cflags",      { "--cflags", NULL, NULL },           TRUE },
+  { "libs-static", { "--libs", "--static", NULL },       TRUE },
+  { "exists",      { "--exists", NULL, NULL },           TRUE },
+  { "modversion",  { "--modversion", NULL, NULL },       TRUE },
+  { "list-all",    { "--list-all", NULL, NULL },         FALSE },
+};
+
+typedef struct
+{
+  gint64 wall;                  /* microseconds */
+  gint64 cpu;
+  long max_rss;                 /* KiB */
+  int status;
+} Run;
+
+static char *pkg_config = "out/pkg-config";
+static char *tree = "out/bench/tree";
+static int runs = 50;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+static const GOptionEntry options_table[] = {
+  { "pkg-config", 0, 0, G_OPTION_ARG_FILENAME, &pkg_config,
+    "binary to measure (out/pkg-config)", "PATH" },
+  { "tree", 0, 0, G_OPTION_ARG_FILENAME, &tree,
+    "tree generated by pcgen (out/bench/tree)", "DIRECTORY" },
+  { "runs", 0, 0, G_OPTION_ARG_INT, &runs,
+    "runs per query type (50)", "N" },
+  { NULL, 0, 0, 0, NULL, NULL, NULL }
+};
+#pragma GCC diagnostic pop
+
+
+/*
+ * Code
+ */
+
+static char *
+read_tree_file (const char *name)
+{
+  GError *error = NULL;
+  char *path;
+  char *contents;
+
+  path = g_strconcat (tree, "/", name, NULL);
+
+  if ( !g_file_get_contents (path, &contents, NULL, &error) )
+    {
+      fprintf (stderr, "%s\n", error->message);
+      g_clear_error (&error);
+      contents = NULL;
+    }
+
+  g_free (path);
+
+  return contents != NULL ? g_strchomp (contents) : NULL;
+}
+
+/* Run pkg-config once with its output thrown away
+ * ATTN: Returns FALSE when it could not be started */
+static gboolean
+run_once (const Query *query, const char *package, Run *run)
+{
+  const char *argv[6];
+  struct rusage usage;
+  gint64 start;
+  pid_t pid;
+  int fd;
+  int i, n = 0;
+
+  argv[n++] = pkg_config;
+  for ( i = 0; i < 3 && query->args[i] != NULL; i++ )
+    argv[n++] = query->args[i];
+  if ( query->with_package )
+    argv[n++] = package;
+  argv[n] = NULL;
+
+  start = g_get_monotonic_time ( );
+
+  pid = fork ( );
+  if ( pid < 0 )
+    return FALSE;
+
+  if ( pid == 0 )
+    {
+      fd = open ("/dev/null", O_WRONLY);
+      if ( fd >= 0 )
+        {
+          dup2 (fd, 1);
+          dup2 (fd, 2);
+          close (fd);
+        }
+
+      execv (pkg_config, (char **) argv);
+      _exit (127);
+    }
+
+  if ( wait4 (pid, &run->status, 0, &usage) < 0 )
+    return FALSE;
+
+  run->wall = g_get_monotonic_time ( ) - start;
+  run->cpu = (gint64) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+             usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+  run->max_rss = usage.ru_maxrss;
+
+  return !(WIFEXITED (run->status) && WEXITSTATUS (run->status) == 127);
+}
+
+static int
+compare_gint64 (gconstpointer a, gconstpointer b)
+{
+  gint64 x = *(const gint64 *) a;
+  gint64 y = *(const gint64 *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+/* Nearest rank percentile of sorted values, in milliseconds */
+static double
+percentile (const gint64 *sorted, int n, int p)
+{
+  int rank;
+
+  rank = (p * n + 99) / 100;
+  if ( rank < 1 )
+    rank = 1;
+
+  return sorted[rank - 1] / 1000.0;
+}
+
+static gboolean
+measure (const Query *query, char **roots, int n_roots, gboolean first)
+{
+  Run run;
+  gint64 *wall;
+  gint64 *cpu;
+  gint64 sum = 0;
+  long max_rss = 0;
+  int failures = 0;
+  int i;
+
+  wall = g_new (gint64, runs);
+  cpu = g_new (gint64, runs);
+
+  /* warm up the page cache */
+  if ( !run_once (query, roots[0], &run) )
+    {
+      fprintf (stderr, "Cannot run '%s'\n", pkg_config);
+      return FALSE;
+    }
+
+  for ( i = 0; i < runs; i++ )
+    {
+      if ( !run_once (query, roots[i % n_roots], &run) )
+        {
+          fprintf (stderr, "Cannot run '%s'\n", pkg_config);
+          return FALSE;
+        }
+
+      if ( !WIFEXITED (run.status) || WEXITSTATUS (run.status) != 0 )
+        failures++;
+
+      wall[i] = run.wall;
+      cpu[i] = run.cpu;
+      sum += run.wall;
+      max_rss = MAX (max_rss, run.max_rss);
+    }
+
+  qsort (wall, runs, sizeof (gint64), compare_gint64);
+  qsort (cpu, runs, sizeof (gint64), compare_gint64);
+
+  printf ("%s\n    \"%s\":{\"runs\":%d,\"failures\":%d,\"wall_ms\":{\"min\":%.3f,\"p50\":%.3f,"
+          "\"p90\":%.3f,\"p99\":%.3f,\"max\":%.3f,\"mean\":%.3f},\"cpu_ms\":{\"p50\":%.3f,"
+          "\"p90\":%.3f},\"max_rss_kib\":%ld}",
+          first ? "" : ",", query->name, runs, failures,
+          wall[0] / 1000.0, percentile (wall, runs, 50), percentile (wall, runs, 90),
+          percentile (wall, runs, 99), wall[runs - 1] / 1000.0, sum / 1000.0 / runs,
+          percentile (cpu, runs, 50), percentile (cpu, runs, 90), max_rss);
+
+  g_free (wall);
+  g_free (cpu);
+
+  return TRUE;
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *opt_context;
+  GError *error = NULL;
+  char *search_path;
+  char *roots_list;
+  char *shape;
+  char **roots;
+  int n_roots;
+  guint i;
+
+  opt_context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (opt_context, options_table, NULL);
+
+  if ( !g_option_context_parse (opt_context, &argc, &argv, &error) )
+    {
+      fprintf (stderr, "%s\n", error->message);
+      return 1;
+    }
+
+  g_option_context_free (opt_context);
+
+  if ( runs < 1 )
+    {
+      fprintf (stderr, "--runs must be at least 1\n");
+      return 1;
+    }
+
+  search_path = read_tree_file ("search-path");
+  roots_list = read_tree_file ("roots");
+  shape = read_tree_file ("shape.json");
+  if ( search_path == NULL || roots_list == NULL || shape == NULL )
+    return 1;
+
+  roots = g_strsplit (roots_list, "\n", -1);
+  n_roots = g_strv_length (roots);
+
+  /* Only the tree is searched and nothing is replayed from a cache */
+  g_setenv ("PKG_CONFIG_LIBDIR", search_path, TRUE);
+  g_unsetenv ("PKG_CONFIG_PATH");
+  g_unsetenv ("PKG_CONFIG_CACHE_DIR");
+  g_unsetenv ("PKG_CONFIG_DEBUG_SPEW");
+
+  printf ("{\n  \"pkg_config\":\"%s\",\n  \"shape\":%s,\n  \"queries\":{", pkg_config, shape);
+
+  for ( i = 0; i < G_N_ELEMENTS (queries); i++ )
+    {
+      if ( !measure (&queries[i], roots, n_roots, i == 0) )
+        return 1;
+    }
+
+  printf ("\n  }\n}\n");
+
+  g_strfreev (roots);
+  g_free (search_path);
+  g_free (roots_list);
+  g_free (shape);
+
+  return 0;
+}
@@ -0,0 +1,417 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Microbenchmarks of the parser and string kernels ("make micro").
+ *
+ * Every kernel is run over a small corpus of lines taken from real .pc
+ * files (long Libs lines, deeply nested ${} references, long version
+ * strings) for a fixed time, and its cost is reported per operation:
+ * nanoseconds and, with glibc, heap allocations. The kernels are linked
+ * from the pkg-config objects themselves. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "flag.h"
+#include "globals.h"
+#include "package.h"
+#include "parse.h"
+#include "reqver.h"
+#include "strutil.h"
+
+
+typedef struct
+{
+  const char *name;
+  guint (*run) (void);          /* one pass over the corpus; returns ops */
+} Kernel;
+
+static int min_time = 200;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+static const GOptionEntry options_table[] = {
+  { "time", 0, 0, G_OPTION_ARG_INT, &min_time,
+    "milliseconds to run each kernel for (200)", "MS" },
+  { NULL, 0, 0, 0, NULL, NULL, NULL }
+};
+#pragma GCC diagnostic pop
+
+
+/*
+ * Corpus
+ */
+
+static const char *pc_file =
+  "# Package Information for pkg-config\n"
+  "\n"
+  "prefix=/usr\n"
+  "exec_prefix=${prefix}\n"
+  "libdir=${prefix}/lib/x86_64-linux-gnu\n"
+  "includedir=${prefix}/include\n"
+  "targets=x11 broadway wayland\n"
+  "gtk_binary_version=3.0.0\n"
+  "gtk_host=x86_64-pc-linux-gnu\n"
+  "\n"
+  "Name: GTK+\n"
+  "Description: GTK+ Graphical UI Library\n"
+  "Version: 3.24.38\n"
+  "Requires: gdk-3.0 atk >= 2.15.1 cairo >= 1.14.0 cairo-gobject >= 1.14.0 \\\n"
+  "  gdk-pixbuf-2.0 >= 2.30.0 gio-2.0 >= 2.57.2\n"
+  "Requires.private: atk epoxy >= 1.4 pangoft2 gio-unix-2.0 >= 2.57.2   # private\n"
+  "Libs: -L${libdir} -lgtk-3 -lgdk-3 -lz -lpangocairo-1.0 -lpango-1.0 -lharfbuzz \\\n"
+  "  -latk-1.0 -lcairo-gobject -lcairo -lgdk_pixbuf-2.0 -lgio-2.0 -lgobject-2.0 -lglib-2.0\n"
+  "Cflags: -I${includedir}/gtk-3.0 -I${includedir}/pango-1.0 -I${includedir}/glib-2.0 \\\n"
+  "  -I${libdir}/glib-2.0/include -I${includedir}/harfbuzz -I${includedir}/freetype2 \\\n"
+  "  -I${includedir}/libpng16 -I${includedir}/libmount -I${includedir}/blkid \\\n"
+  "  -I${includedir}/fribidi -I${includedir}/cairo -I${includedir}/pixman-1 \\\n"
+  "  -I${includedir}/gdk-pixbuf-2.0 -I${includedir}/gio-unix-2.0 -I${includedir}/atk-1.0 \\\n"
+  "  -I${includedir}/at-spi2-atk/2.0 -I${includedir}/at-spi-2.0 -pthread\n";
+
+static const char *long_libs =
+  "-L${libdir} -lavdevice -lavfilter -lavformat -lavcodec -lpostproc -lswresample "
+  "-lswscale -lavutil -lx264 -lx265 -lvpx -lopus -lmp3lame -lvorbis -lvorbisenc "
+  "-logg -ltheoraenc -ltheoradec -lfdk-aac -lass -lfreetype -lfontconfig -lfribidi "
+  "-lharfbuzz -lz -lbz2 -llzma -lm -pthread -ldl -Wl,--as-needed -Wl,-rpath,${libdir}";
+
+/* Values to expand; the package variables are set up in main */
+static const char *expand_lines[] = {
+  "-L${libdir} -lgtk-3 -lgdk-3 -lz -lpangocairo-1.0 -lpango-1.0 -lharfbuzz -latk-1.0",
+  "-I${includedir}/gtk-3.0 -I${includedir}/pango-1.0 -I${includedir}/glib-2.0 "
+    "-I${libdir}/glib-2.0/include -I${includedir}/harfbuzz -I${includedir}/cairo",
+  "${libdir}/gtk-3.0/${gtk_binary_version}/${gtk_host}/immodules",
+  "${v7}/bin ${v7}/sbin ${v6}/share $${literal}",
+  "-DPREFIX=\\\"${prefix}\\\" -DLIBDIR=\\\"${libdir}\\\" -DTARGETS=\\\"${targets}\\\"",
+};
+
+static const char *version_pairs[][2] = {
+  { "1.2.3", "1.2.10" },
+  { "2.74.1-1ubuntu0.1", "2.74.1-1ubuntu0.2" },
+  { "1:9.18.28-0ubuntu0.22.04.1~esm1", "1:9.18.28-0ubuntu0.22.04.1" },
+  { "20230802.1.0.0.rc3.git20230901.abcdef0123", "20230802.1.0.0.rc3.git20230901.abcdef0124" },
+  { "3.0.0~beta2", "3.0.0" },
+  { "60.31.102", "60.31.102" },
+  { "1.0.0a", "1.0.0b" },
+  { "2023.10.19.1.2.3.4.5.6.7.8.9", "2023.10.19.1.2.3.4.5.6.7.8.10" },
+};
+
+static const char *module_lists[] = {
+  "glib-2.0 >= 2.57.2, gobject-2.0 >= 2.57.2, gio-2.0 >= 2.57.2, pango >= 1.41.0, "
+    "cairo >= 1.14.0, cairo-gobject >= 1.14.0, gdk-pixbuf-2.0 >= 2.30.0, atk >= 2.15.1, epoxy >= 1.4",
+  "libavutil = 58.29.100, libswresample = 4.12.100, libavcodec = 60.31.102",
+  "x11 xext xrender xi xrandr xcursor xfixes xcomposite xdamage xinerama",
+  "gstreamer-1.0>=1.22.0,gstreamer-base-1.0>=1.22.0 , gstreamer-video-1.0 >=1.22.0",
+};
+
+static const char *shell_args[] = {
+  "-I/usr/include/glib-2.0",
+  "-L/usr/lib/x86_64-linux-gnu",
+  "-DPACKAGE_DATA_DIR=\"/usr/share/foo bar\"",
+  "-Wl,-rpath,$ORIGIN/../lib",
+  "-I/opt/vendor (x86)/include",
+  "-lgdk_pixbuf-2.0",
+  "-DVERSION_STRING=\"3.24.38 (built on 'builder')\"",
+  "-pthread",
+};
+
+static Package *pkg;
+
+/* Flags with the runs of duplicates merging produces */
+static GArray *flags_template;
+static GArray *flags;
+
+
+/*
+ * Allocation counting
+ */
+
+static guint64 allocations = 0;
+
+#ifdef __GLIBC__
+#define HAVE_ALLOCATION_COUNT 1
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t n, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+/* Interposed for everything in the process, glib included */
+void *
+malloc (size_t size)
+{
+  allocations++;
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t n, size_t size)
+{
+  allocations++;
+  return __libc_calloc (n, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+  allocations++;
+  return __libc_realloc (ptr, size);
+}
+#else
+#define HAVE_ALLOCATION_COUNT 0
+#endif
+
+
+/*
+ * Kernels
+ */
+
+static guint
+run_read_one_line (void)
+{
+  static GString *str = NULL;
+  FILE *f;
+  guint lines = 0;
+
+  if ( str == NULL )
+    str = g_string_new (NULL);
+
+  f = fmemopen ((char *) pc_file, strlen (pc_file), "r");
+
+  while ( read_one_line (f, str) )
+    lines++;
+
+  fclose (f);
+
+  return lines;
+}
+
+static guint
+run_escape_shell (void)
+{
+  guint i;
+
+  for ( i = 0; i < G_N_ELEMENTS (shell_args); i++ )
+    g_free (s_dup_escape_shell (shell_args[i]));
+
+  return G_N_ELEMENTS (shell_args);
+}
+
+static guint
+run_compare_versions (void)
+{
+  volatile int sink = 0;
+  guint i;
+
+  for ( i = 0; i < G_N_ELEMENTS (version_pairs); i++ )
+    sink += compare_versions (version_pairs[i][0], version_pairs[i][1]);
+
+  (void) sink;
+
+  return G_N_ELEMENTS (version_pairs);
+}
+
+static guint
+run_parse_module_list (void)
+{
+  gboolean die;
+  GList *list;
+  guint i;
+
+  for ( i = 0; i < G_N_ELEMENTS (module_lists); i++ )
+    {
+      list = parse_module_list (pkg, NULL, module_lists[i], "bench.pc", &die);
+      required_version_free_list (list);
+    }
+
+  return G_N_ELEMENTS (module_lists);
+}
+
+static guint
+run_trim_and_sub (void)
+{
+  guint i;
+
+  for ( i = 0; i < G_N_ELEMENTS (expand_lines); i++ )
+    g_free (package_trim_and_sub (pkg, NULL, expand_lines[i], "bench.pc"));
+
+  g_free (package_trim_and_sub (pkg, NULL, long_libs, "bench.pc"));
+
+  return G_N_ELEMENTS (expand_lines) + 1;
+}
+
+/* Includes copying the template back in, which allocates nothing */
+static guint
+run_strip_duplicates (void)
+{
+  g_array_set_size (flags, flags_template->len);
+  memcpy (flags->data, flags_template->data, flags_template->len * sizeof (Flag));
+
+  flag_list_strip_duplicates (flags);
+
+  return 1;
+}
+
+static guint
+run_list_to_string (void)
+{
+  g_free (flag_list_to_string (flags_template));
+
+  return 1;
+}
+
+static const Kernel kernels[] = {
+  { "read_one_line",              run_read_one_line },
+  { "s_dup_escape_shell",         run_escape_shell },
+  { "compare_versions",           run_compare_versions },
+  { "parse_module_list",          run_parse_module_list },
+  { "package_trim_and_sub",       run_trim_and_sub },
+  { "flag_list_strip_duplicates", run_strip_duplicates },
+  { "flag_list_to_string",        run_list_to_string },
+};
+
+
+/*
+ * Code
+ */
+
+static void
+setup (void)
+{
+  char **args;
+  Flag flag;
+  char name[8];
+  char value[32];
+  int i, j;
+
+  pkg = package_new (g_strdup ("bench"));
+
+  package_add_var (pkg, "prefix", "/usr");
+  package_add_var (pkg, "exec_prefix", "${prefix}");
+  package_add_var (pkg, "libdir", "/usr/lib/x86_64-linux-gnu");
+  package_add_var (pkg, "includedir", "/usr/include");
+  package_add_var (pkg, "targets", "x11 broadway wayland");
+  package_add_var (pkg, "gtk_binary_version", "3.0.0");
+  package_add_var (pkg, "gtk_host", "x86_64-pc-linux-gnu");
+
+  /* v0 .. v7 as the parser stores them: already expanded */
+  for ( i = 0; i < 8; i++ )
+    {
+      g_snprintf (name, sizeof (name), "v%d", i);
+      g_snprintf (value, sizeof (value), "/usr/lib/v%d", i);
+      package_add_var (pkg, name, value);
+    }
+
+  /* Every argument of the long Libs line three times over, as merged from
+   * packages that share most of their dependencies */
+  args = g_strsplit (long_libs, " ", -1);
+  flags_template = g_array_new (FALSE, FALSE, sizeof (Flag));
+
+  for ( j = 0; j < 3; j++ )
+    for ( i = 0; args[i] != NULL; i++ )
+      {
+        flag.type = strncmp (args[i], "-l", 2) == 0 ? LIBS_l :
+                    strncmp (args[i], "-L", 2) == 0 ? LIBS_L : LIBS_OTHER;
+        flag.arg = args[i];
+
+        g_array_append_val (flags_template, flag);
+        if ( i % 2 == 0 )
+          g_array_append_val (flags_template, flag);
+      }
+
+  flags = g_array_new (FALSE, FALSE, sizeof (Flag));
+}
+
+static void
+measure (const Kernel *kernel)
+{
+  guint64 ops = 0;
+  guint64 allocs;
+  gint64 start;
+  gint64 elapsed;
+  guint64 rounds;
+  guint64 i;
+
+  /* warm up */
+  kernel->run ( );
+
+  /* grow the batch until it lasts long enough to time */
+  for ( rounds = 1; ; rounds *= 2 )
+    {
+      ops = 0;
+      allocs = allocations;
+      start = g_get_monotonic_time ( );
+
+      for ( i = 0; i < rounds; i++ )
+        ops += kernel->run ( );
+
+      elapsed = g_get_monotonic_time ( ) - start;
+      allocs = allocations - allocs;
+
+      if ( elapsed >= (gint64) min_time * 1000 )
+        break;
+    }
+
+  if ( HAVE_ALLOCATION_COUNT )
+    printf ("%-28s %12.1f %12.2f %12" G_GUINT64_FORMAT "\n", kernel->name,
+            elapsed * 1000.0 / ops, (double) allocs / ops, ops);
+  else
+    printf ("%-28s %12.1f %12s %12" G_GUINT64_FORMAT "\n", kernel->name,
+            elapsed * 1000.0 / ops, "n/a", ops);
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *opt_context;
+  GError *error = NULL;
+  guint i;
+  int j;
+
+  opt_context = g_option_context_new ("[KERNEL...]");
+  g_option_context_add_main_entries (opt_context, options_table, NULL);
+
+  if ( !g_option_context_parse (opt_context, &argc, &argv, &error) )
+    {
+      fprintf (stderr, "%s\n", error->message);
+      return 1;
+    }
+
+  g_option_context_free (opt_context);
+
+  /* Unknown variables must not abort the run */
+  parse_strict = FALSE;
+
+  setup ( );
+
+  printf ("%-28s %12s %12s %12s\n", "kernel", "ns/op", "allocs/op", "ops");
+
+  for ( i = 0; i < G_N_ELEMENTS (kernels); i++ )
+    {
+      /* only the kernels named on the command line, if any */
+      for ( j = 1; j < argc && strcmp (argv[j], kernels[i].name) != 0; j++ )
+        ;
+
+      if ( argc == 1 || j < argc )
+        measure (&kernels[i]);
+    }
+
+  return 0;
+}
@@ -0,0 +1,397 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+/* Synthetic .pc tree generator for "make bench".
+ *
+ * Packages p0 .. pN-1 are laid out in 'depth' levels; every package of a
+ * level requires 'fanout' packages of the next one. A share of those
+ * requirements ('diamonds' percent) is taken from a small set of popular
+ * packages of the next level, so that the dependency graph has many
+ * diamonds, the rest is picked uniformly. The files are spread over
+ * 'dirs' search directories and some packages also get an -uninstalled
+ * variant. The generator is deterministic for a given seed.
+ *
+ * Besides the .pc files, the tree gets
+ *   search-path   the directories to use as PKG_CONFIG_LIBDIR
+ *   roots         the packages of the first level, one per line
+ *   shape.json    the parameters the tree was generated with
+ */
+
+#include <stdio.h>
+
+#include <glib.h>
+
+
+static int n_packages = 1000;
+static int depth = 8;
+static int fanout = 3;
+static int diamonds = 30;
+static int n_variables = 8;
+static int n_flags = 6;
+static int n_dirs = 4;
+static int uninstalled = 5;
+static int seed = 1;
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+static const GOptionEntry options_table[] = {
+  { "packages", 0, 0, G_OPTION_ARG_INT, &n_packages,
+    "number of packages (1000)", "N" },
+  { "depth", 0, 0, G_OPTION_ARG_INT, &depth,
+    "number of levels of the dependency graph (8)", "N" },
+  { "fanout", 0, 0, G_OPTION_ARG_INT, &fanout,
+    "requirements per package (3)", "N" },
+  { "diamonds", 0, 0, G_OPTION_ARG_INT, &diamonds,
+    "percentage of requirements on popular packages (30)", "PERCENT" },
+  { "variables", 0, 0, G_OPTION_ARG_INT, &n_variables,
+    "variables per file besides prefix, exec_prefix, libdir and "
+    "includedir (8)", "N" },
+  { "flags", 0, 0, G_OPTION_ARG_INT, &n_flags,
+    "flags per Libs line (6)", "N" },
+  { "dirs", 0, 0, G_OPTION_ARG_INT, &n_dirs,
+    "number of search directories (4)", "N" },
+  { "uninstalled", 0, 0, G_OPTION_ARG_INT, &uninstalled,
+    "percentage of packages with an -uninstalled variant (5)", "PERCENT" },
+  { "seed", 0, 0, G_OPTION_ARG_INT, &seed,
+    "random seed (1)", "N" },
+  { NULL, 0, 0, 0, NULL, NULL, NULL }
+};
+#pragma GCC diagnostic pop
+
+
+static guint64 rng_state;
+
+
+/*
+ * Code
+ */
+
+/* splitmix64; the same trees on every platform and glib version */
+static guint64
+rng_next (void)
+{
+  guint64 z;
+
+  z = (rng_state += G_GUINT64_CONSTANT (0x9E3779B97F4A7C15));
+  z = (z ^ (z >> 30)) * G_GUINT64_CONSTANT (0xBF58476D1CE4E5B9);
+  z = (z ^ (z >> 27)) * G_GUINT64_CONSTANT (0x94D049BB133111EB);
+
+  return z ^ (z >> 31);
+}
+
+/* Random number in [0, n) */
+static int
+rng_range (int n)
+{
+  return (int) (rng_next ( ) % (guint64) n);
+}
+
+/* First package of a level; level 'depth' is the end of the last one */
+static int
+level_start (int level)
+{
+  return (int) ((gint64) level * n_packages / depth);
+}
+
+static int
+level_of (int package)
+{
+  int level;
+
+  level = (int) ((gint64) package * depth / n_packages);
+
+  /* rounding */
+  while ( level + 1 < depth && level_start (level + 1) <= package )
+    level++;
+  while ( level > 0 && level_start (level) > package )
+    level--;
+
+  return level;
+}
+
+/* Pick the requirements of a package; returns how many were picked */
+static int
+pick_requires (int package, int *requires)
+{
+  int level;
+  int first, width, popular;
+  int count = 0;
+  int tries;
+  int req;
+  int i, j;
+
+  level = level_of (package);
+  if ( level + 1 >= depth )
+    return 0;
+
+  first = level_start (level + 1);
+  width = level_start (level + 2) - first;
+  if ( width <= 0 )
+    return 0;
+
+  popular = MAX (1, width / 8);
+
+  for ( i = 0; i < fanout; i++ )
+    {
+      for ( tries = 0; tries < 8; tries++ )
+        {
+          if ( rng_range (100) < diamonds )
+            req = first + rng_range (popular);
+          else
+            req = first + rng_range (width);
+
+          for ( j = 0; j < count && requires[j] != req; j++ )
+            ;
+
+          if ( j == count )
+            {
+              requires[count++] = req;
+              break;
+            }
+        }
+    }
+
+  return count;
+}
+
+static void
+append_requires (GString *str, const char *field, const int *requires, int count, gboolean private)
+{
+  gboolean first = TRUE;
+  int i;
+
+  for ( i = 0; i < count; i++ )
+    {
+      /* every third requirement is a private one */
+      if ( (i % 3 == 2) != private )
+        continue;
+
+      g_string_append (str, first ? field : ", ");
+      g_string_append_printf (str, "p%d", requires[i]);
+
+      if ( i % 2 == 0 )
+        g_string_append (str, " >= 1.0");
+
+      first = FALSE;
+    }
+
+  if ( !first )
+    g_string_append_c (str, '\n');
+}
+
+static char *
+package_contents (int package, const char *prefix, const int *requires, int count)
+{
+  GString *str;
+  int i;
+
+  str = g_string_new (NULL);
+
+  g_string_append_printf (str, "prefix=%s/p%d\n", prefix, package);
+  g_string_append (str, "exec_prefix=${prefix}\n"
+                        "libdir=${exec_prefix}/lib\n"
+                        "includedir=${prefix}/include\n");
+
+  /* each variable refers to the one before, so expansion nests deeply */
+  for ( i = 0; i < n_variables; i++ )
+    {
+      if ( i == 0 )
+        g_string_append_printf (str, "var0=${libdir}/p%d-0\n", package);
+      else
+        g_string_append_printf (str, "var%d=${var%d}/%d\n", i, i - 1, i);
+    }
+
+  g_string_append_printf (str, "\nName: p%d\n"
+                               "Description: Synthetic package %d\n"
+                               "URL: https://example.org/p%d\n"
+                               "Version: 1.%d.%d\n",
+                          package, package, package, package % 7, package % 100);
+
+  append_requires (str, "Requires: ", requires, count, FALSE);
+  append_requires (str, "Requires.private: ", requires, count, TRUE);
+
+  g_string_append_printf (str, "Libs: -L${libdir} -lp%d", package);
+
+  /* shared names are merged away by the deduplication */
+  for ( i = 2; i < n_flags; i++ )
+    {
+      if ( i % 3 == 0 )
+        g_string_append_printf (str, " -lshared%d", (package + i) % 16);
+      else if ( i % 3 == 1 && n_variables > 0 )
+        g_string_append_printf (str, " -Wl,-rpath,${var%d}", i % n_variables);
+      else
+        g_string_append_printf (str, " -L${libdir}/extra%d", i);
+    }
+
+  g_string_append (str, "\nLibs.private: -lm -pthread\n");
+  g_string_append_printf (str, "Cflags: -I${includedir} -I${includedir}/p%d -DHAVE_P%d=1\n",
+                          package, package);
+
+  return g_string_free (str, FALSE);
+}
+
+static gboolean
+write_file (const char *path, const char *contents)
+{
+  GError *error = NULL;
+
+  if ( !g_file_set_contents (path, contents, -1, &error) )
+    {
+      fprintf (stderr, "%s\n", error->message);
+      g_clear_error (&error);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+write_tree (const char *out)
+{
+  GString *search_path;
+  GString *roots;
+  char *dir;
+  char *path;
+  char *name;
+  char *contents;
+  int *requires;
+  int count;
+  int i;
+
+  search_path = g_string_new (NULL);
+
+  for ( i = 0; i < n_dirs; i++ )
+    {
+      dir = g_strdup_printf ("%s/dir%d", out, i);
+
+      if ( g_mkdir_with_parents (dir, 0755) != 0 )
+        {
+          fprintf (stderr, "Cannot create directory '%s'\n", dir);
+          return FALSE;
+        }
+
+      g_string_append_printf (search_path, "%s%s", i > 0 ? ":" : "", dir);
+      g_free (dir);
+    }
+
+  g_string_append_c (search_path, '\n');
+
+  requires = g_new (int, MAX (fanout, 1));
+
+  for ( i = 0; i < n_packages; i++ )
+    {
+      count = pick_requires (i, requires);
+
+      name = g_strdup_printf ("%s/dir%d/p%d", out, i % n_dirs, i);
+
+      path = g_strconcat (name, ".pc", NULL);
+      contents = package_contents (i, "/opt/bench", requires, count);
+
+      if ( !write_file (path, contents) )
+        return FALSE;
+
+      g_free (contents);
+      g_free (path);
+
+      if ( rng_range (100) < uninstalled )
+        {
+          path = g_strconcat (name, "-uninstalled.pc", NULL);
+          contents = package_contents (i, "/build/bench", requires, count);
+
+          if ( !write_file (path, contents) )
+            return FALSE;
+
+          g_free (contents);
+          g_free (path);
+        }
+
+      g_free (name);
+    }
+
+  g_free (requires);
+
+  roots = g_string_new (NULL);
+  for ( i = 0; i < level_start (1); i++ )
+    g_string_append_printf (roots, "p%d\n", i);
+
+  path = g_strconcat (out, "/search-path", NULL);
+  if ( !write_file (path, search_path->str) )
+    return FALSE;
+  g_free (path);
+
+  path = g_strconcat (out, "/roots", NULL);
+  if ( !write_file (path, roots->str) )
+    return FALSE;
+  g_free (path);
+
+  g_string_free (search_path, TRUE);
+  g_string_free (roots, TRUE);
+
+  contents = g_strdup_printf ("{\"packages\":%d,\"depth\":%d,\"fanout\":%d,\"diamonds\":%d,"
+                              "\"variables\":%d,\"flags\":%d,\"dirs\":%d,\"uninstalled\":%d,"
+                              "\"seed\":%d}\n",
+                              n_packages, depth, fanout, diamonds, n_variables,
+                              n_flags, n_dirs, uninstalled, seed);
+
+  path = g_strconcat (out, "/shape.json", NULL);
+  if ( !write_file (path, contents) )
+    return FALSE;
+
+  g_free (path);
+  g_free (contents);
+
+  return TRUE;
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *opt_context;
+  GError *error = NULL;
+
+  opt_context = g_option_context_new ("DIRECTORY");
+  g_option_context_add_main_entries (opt_context, options_table, NULL);
+
+  if ( !g_option_context_parse (opt_context, &argc, &argv, &error) )
+    {
+      fprintf (stderr, "%s\n", error->message);
+      return 1;
+    }
+
+  g_option_context_free (opt_context);
+
+  if ( argc != 2 )
+    {
+      fprintf (stderr, "usage: %s [OPTION...] DIRECTORY\n", argv[0]);
+      return 1;
+    }
+
+  if ( n_packages < 1 || depth < 1 || depth > n_packages || fanout < 0 ||
+       diamonds < 0 || diamonds > 100 || n_variables < 0 || n_flags < 2 ||
+       n_dirs < 1 || uninstalled < 0 || uninstalled > 100 )
+    {
+      fprintf (stderr, "Invalid tree shape: need packages >= depth >= 1, flags >= 2, "
+                       "dirs >= 1 and percentages between 0 and 100\n");
+      return 1;
+    }
+
+  rng_state = (guint64) seed;
+
+  return write_tree (argv[1]) ? 0 : 1;
+}
@@ -0,0 +1,473 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if ENABLE_IO_URING
+#include <linux/io_uring.h>
+#include <linux/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "bulkload.h"
+#include "inputs.h"
+#include "prefetch.h"
+#include "strutil.h"
+#include "utils.h"
+
+
+typedef struct
+{
+  char *path;
+  int fd;
+  char *contents;
+  gsize length;
+  gboolean loaded;
+  Input snapshot;
+#if ENABLE_IO_URING
+  struct statx stx;
+#endif
+} BulkFile;
+
+
+/*
+ * Code
+ */
+
+/* Portable fallback, also used for the files io_uring couldn't load */
+static void
+bulk_load_file (BulkFile *file)
+{
+  if ( !input_stat (&file->snapshot, file->path, FALSE) )
+    return;
+
+  if ( g_file_get_contents (file->path, &file->contents, &file->length, NULL) )
+    file->loaded = TRUE;
+}
+
+#if ENABLE_IO_URING
+
+/* Files per batch; each needs two submission entries (openat + statx) */
+#define BULK_BATCH   128
+
+typedef struct
+{
+  int fd;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  void *sq_ring;
+  void *cq_ring;
+  size_t sq_ring_size;
+  size_t cq_ring_size;
+  size_t sqes_size;
+} Ring;
+
+static gboolean
+ring_init (Ring *ring, unsigned entries)
+{
+  struct io_uring_params params;
+  char *sq, *cq;
+
+  memset (&params, 0, sizeof (params));
+  memset (ring, 0, sizeof (Ring));
+
+  /* ENOSYS on old kernels, EPERM when forbidden by a seccomp policy */
+  ring->fd = (int) syscall (__NR_io_uring_setup, entries, &params);
+  if ( ring->fd < 0 )
+    return FALSE;
+
+  ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+  ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+
+  if ( params.features & IORING_FEAT_SINGLE_MMAP )
+    {
+      ring->sq_ring_size = MAX (ring->sq_ring_size, ring->cq_ring_size);
+      ring->cq_ring_size = ring->sq_ring_size;
+    }
+
+  ring->sq_ring = mmap (NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if ( ring->sq_ring == MAP_FAILED )
+    goto fail;
+
+  if ( params.features & IORING_FEAT_SINGLE_MMAP )
+    ring->cq_ring = ring->sq_ring;
+  else
+    {
+      ring->cq_ring = mmap (NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+      if ( ring->cq_ring == MAP_FAILED )
+        {
+          munmap (ring->sq_ring, ring->sq_ring_size);
+          goto fail;
+        }
+    }
+
+  ring->sqes_size = params.sq_entries * sizeof (struct io_uring_sqe);
+  ring->sqes = mmap (NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if ( ring->sqes == MAP_FAILED )
+    {
+      if ( ring->cq_ring != ring->sq_ring )
+        munmap (ring->cq_ring, ring->cq_ring_size);
+
+      munmap (ring->sq_ring, ring->sq_ring_size);
+      goto fail;
+    }
+
+  sq = ring->sq_ring;
+  ring->sq_tail = (unsigned *) (sq + params.sq_off.tail);
+  ring->sq_mask = (unsigned *) (sq + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned *) (sq + params.sq_off.array);
+
+  cq = ring->cq_ring;
+  ring->cq_head = (unsigned *) (cq + params.cq_off.head);
+  ring->cq_tail = (unsigned *) (cq + params.cq_off.tail);
+  ring->cq_mask = (unsigned *) (cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+
+  return TRUE;
+
+fail:
+
+  close (ring->fd);
+  return FALSE;
+}
+
+static void
+ring_exit (Ring *ring)
+{
+  munmap (ring->sqes, ring->sqes_size);
+
+  if ( ring->cq_ring != ring->sq_ring )
+    munmap (ring->cq_ring, ring->cq_ring_size);
+
+  munmap (ring->sq_ring, ring->sq_ring_size);
+  close (ring->fd);
+}
+
+/* We are the only producer, so the entry is published right away; the
+ * kernel doesn't look at it before io_uring_enter */
+static struct io_uring_sqe *
+ring_get_sqe (Ring *ring, __u8 opcode, int fd, __u64 user_data)
+{
+  struct io_uring_sqe *sqe;
+  unsigned tail, index;
+
+  tail = *ring->sq_tail;
+  index = tail & *ring->sq_mask;
+
+  sqe = &ring->sqes [index];
+  memset (sqe, 0, sizeof (struct io_uring_sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->user_data = user_data;
+
+  ring->sq_array [index] = index;
+  __atomic_store_n (ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  return sqe;
+}
+
+/* Submit 'count' entries and wait for all of their completions; 'func' is
+ * called for each one. ATTN: Returns FALSE when the ring is unusable */
+static gboolean
+ring_run (Ring *ring, unsigned count,
+          void (*func) (BulkFile *files, __u64 user_data, int res),
+          BulkFile *files)
+{
+  struct io_uring_cqe *cqe;
+  unsigned head, tail;
+  unsigned reaped = 0;
+  long ret;
+
+  if ( count == 0 )
+    return TRUE;
+
+  do
+    ret = syscall (__NR_io_uring_enter, ring->fd, count, count,
+                   IORING_ENTER_GETEVENTS, NULL, 0);
+  while ( ret < 0 && errno == EINTR );
+
+  if ( ret != (long) count )
+    return FALSE;
+
+  while ( reaped < count )
+    {
+      head = *ring->cq_head;
+      tail = __atomic_load_n (ring->cq_tail, __ATOMIC_ACQUIRE);
+
+      if ( head == tail )
+        {
+          /* Interrupted wait; ask again for the rest */
+          do
+            ret = syscall (__NR_io_uring_enter, ring->fd, 0, count - reaped,
+                           IORING_ENTER_GETEVENTS, NULL, 0);
+          while ( ret < 0 && errno == EINTR );
+
+          if ( ret < 0 )
+            return FALSE;
+
+          continue;
+        }
+
+      for ( ; head != tail; head++, reaped++ )
+        {
+          cqe = &ring->cqes [head & *ring->cq_mask];
+          func (files, cqe->user_data, cqe->res);
+        }
+
+      __atomic_store_n (ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+
+  return TRUE;
+}
+
+static void
+bulk_open_done (BulkFile *files, __u64 user_data, int res)
+{
+  BulkFile *file = &files [user_data >> 1];
+
+  if ( (user_data & 1) == 0 )
+    {
+      file->fd = res;   /* -errno on failure */
+      return;
+    }
+
+  if ( res != 0 )
+    return;
+
+  file->snapshot.exists = TRUE;
+  file->snapshot.is_dir = FALSE;
+  file->snapshot.mtime = (gint64) file->stx.stx_mtime.tv_sec * 1000000000
+                         + file->stx.stx_mtime.tv_nsec;
+  file->snapshot.size = (gint64) file->stx.stx_size;
+}
+
+static void
+bulk_read_done (BulkFile *files, __u64 user_data, int res)
+{
+  BulkFile *file = &files [user_data];
+
+  /* One byte more than the size was asked for, so a file that has grown
+   * since the statx shows up here and is read again the portable way */
+  if ( res >= 0 && (__u64) res == file->stx.stx_size )
+    {
+      file->length = res;
+      file->loaded = TRUE;
+      return;
+    }
+
+  g_free (file->contents);
+  file->contents = NULL;
+}
+
+static void
+bulk_close_done (BulkFile *files, __u64 user_data, int res)
+{
+  files [user_data].fd = -1;
+}
+
+/* Three rounds per batch: openat + statx, read, close
+ * ATTN: Returns FALSE when the ring is unusable */
+static gboolean
+bulk_load_batch (Ring *ring, BulkFile *files, unsigned count)
+{
+  struct io_uring_sqe *sqe;
+  BulkFile *file;
+  unsigned submit;
+  unsigned i;
+
+  for ( i = 0; i < count; i++ )
+    {
+      file = &files [i];
+      file->fd = -1;
+
+      sqe = ring_get_sqe (ring, IORING_OP_OPENAT, AT_FDCWD, (__u64) i << 1);
+      sqe->addr = (__u64) (uintptr_t) file->path;
+      sqe->open_flags = O_RDONLY | O_CLOEXEC;
+
+      sqe = ring_get_sqe (ring, IORING_OP_STATX, AT_FDCWD, ((__u64) i << 1) | 1);
+      sqe->addr = (__u64) (uintptr_t) file->path;
+      sqe->len = STATX_BASIC_STATS;
+      sqe->off = (__u64) (uintptr_t) &file->stx;
+    }
+
+  if ( !ring_run (ring, count * 2, bulk_open_done, files) )
+    return FALSE;
+
+  for ( i = 0, submit = 0; i < count; i++ )
+    {
+      file = &files [i];
+
+      if ( file->fd < 0 || !file->snapshot.exists || !S_ISREG (file->stx.stx_mode) )
+        continue;
+
+      file->contents = g_malloc (file->stx.stx_size + 1);
+
+      sqe = ring_get_sqe (ring, IORING_OP_READ, file->fd, i);
+      sqe->addr = (__u64) (uintptr_t) file->contents;
+      sqe->len = file->stx.stx_size + 1;
+      submit++;
+    }
+
+  if ( !ring_run (ring, submit, bulk_read_done, files) )
+    return FALSE;
+
+  for ( i = 0, submit = 0; i < count; i++ )
+    {
+      if ( files [i].fd < 0 )
+        continue;
+
+      ring_get_sqe (ring, IORING_OP_CLOSE, files [i].fd, i);
+      submit++;
+    }
+
+  return ring_run (ring, submit, bulk_close_done, files);
+}
+
+static void
+bulk_load_files (BulkFile *files, unsigned count)
+{
+  Ring ring;
+  unsigned done;
+  unsigned i;
+
+  if ( !ring_init (&ring, BULK_BATCH * 2) )
+    {
+      debug_spew ("io_uring is not available: %s\n", g_strerror (errno));
+
+      for ( i = 0; i < count; i++ )
+        bulk_load_file (&files [i]);
+
+      return;
+    }
+
+  for ( done = 0; done < count; done += BULK_BATCH )
+    {
+      if ( !bulk_load_batch (&ring, files + done, MIN (BULK_BATCH, count - done)) )
+        break;
+    }
+
+  ring_exit (&ring);
+
+  /* Whatever failed (or wasn't reached) is retried the portable way.
+   * Files still open were left behind by a broken ring. */
+  for ( i = 0; i < count; i++ )
+    {
+      if ( files [i].fd >= 0 )
+        close (files [i].fd);
+
+      if ( !files [i].loaded )
+        {
+          g_free (files [i].contents);
+          files [i].contents = NULL;
+          bulk_load_file (&files [i]);
+        }
+    }
+}
+
+#else
+
+static void
+bulk_load_files (BulkFile *files, unsigned count)
+{
+  unsigned i;
+
+  for ( i = 0; i < count; i++ )
+    bulk_load_file (&files [i]);
+}
+
+#endif  /* ENABLE_IO_URING */
+
+/* Collect the .pc files with exactly the paths scan_dir will ask for */
+static void
+bulk_collect_dir (GArray *files, const char *dirname)
+{
+  GDir *dir;
+  const gchar *filename;
+  char *tmpname;
+  BulkFile file;
+
+  tmpname = file_strip_dir_separator (dirname);
+
+  dir = g_dir_open (tmpname, 0, NULL);
+  if ( dir == NULL )
+    {
+      g_free (tmpname);
+      return;
+    }
+
+  for ( filename = g_dir_read_name (dir); filename != NULL; filename = g_dir_read_name (dir) )
+    {
+      if ( !ends_in_dotpc (filename) )
+        continue;
+
+      memset (&file, 0, sizeof (BulkFile));
+      file.path = g_build_filename (tmpname, filename, NULL);
+      file.fd = -1;
+      g_array_append_val (files, file);
+    }
+
+  g_dir_close (dir);
+  g_free (tmpname);
+}
+
+void
+bulk_load_dirs (GList *dirs)
+{
+  GArray *files;
+  BulkFile *file;
+  GList *iter;
+  guint i;
+
+  files = g_array_new (FALSE, FALSE, sizeof (BulkFile));
+
+  for ( iter = dirs; iter != NULL; iter = iter->next )
+    bulk_collect_dir (files, iter->data);
+
+  debug_spew ("Loading %u package files\n", files->len);
+
+  bulk_load_files ((BulkFile *) (void *) files->data, files->len);
+
+  for ( i = 0; i < files->len; i++ )
+    {
+      file = &g_array_index (files, BulkFile, i);
+
+      /* The parser takes the buffer from here */
+      if ( file->loaded )
+        prefetch_add (file->path, file->contents, file->length, &file->snapshot);
+      else
+        g_free (file->contents);
+
+      g_free (file->path);
+    }
+
+  g_array_free (files, TRUE);
+}
@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "cache.h"
+#include "capture.h"
+#include "inputs.h"
+#include "probes.h"
+#include "utils.h"
+
+
+/*
+ * An entry is a file named after the query key in $PKG_CONFIG_CACHE_DIR:
+ *
+ *   pkg-config-cache 1
+ *   status <exit status>
+ *   input <f|d> <exists> <mtime> <size> <path>
+ *   ...
+ *   output <length>
+ *   <stdout bytes>
+ *
+ * Entries are written to a temporary file and renamed into place, so a
+ * reader sees either the old or the new entry and never waits for a lock.
+ */
+#define CACHE_MAGIC   "pkg-config-cache 1"
+
+extern char **environ;
+
+/* Compiler variables consulted by cflag_init_system_dirs */
+static const char *cache_env_vars[] = {
+  "CPATH",
+  "C_INCLUDE_PATH",
+  "CPP_INCLUDE_PATH",
+  "INCLUDE",
+  NULL
+};
+
+static char *cache_dir = NULL;
+static char *cache_key = NULL;
+static gboolean cache_enabled = FALSE;
+
+
+/*
+ * Code
+ */
+
+void
+cache_disable (void)
+{
+  cache_enabled = FALSE;
+}
+
+/* Whether an environment entry ("NAME=value") may change the answer */
+gboolean
+cache_env_relevant (const char *entry)
+{
+  const char **iter;
+  size_t len;
+
+  if ( strncmp (entry, "PKG_CONFIG_", 11) == 0 )
+    return TRUE;
+
+  for ( iter = cache_env_vars; *iter != NULL; iter++ )
+    {
+      len = strlen (*iter);
+      if ( strncmp (entry, *iter, len) == 0 && entry[len] == '=' )
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+cache_checksum_string (GChecksum *checksum, const char *str)
+{
+  /* Include the terminator so "a" "bc" and "ab" "c" differ */
+  g_checksum_update (checksum, (const guchar *) str, strlen (str) + 1);
+}
+
+static char *
+cache_compute_key (int argc, char **argv)
+{
+  GChecksum *checksum;
+  GPtrArray *env;
+  char **iter;
+  char *path;
+  char *contents;
+  gsize length;
+  char *cwd;
+  char *key;
+  guint i;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  cache_checksum_string (checksum, CACHE_MAGIC);
+  cache_checksum_string (checksum, VERSION);
+
+  /* Relative search paths and .pc file names depend on it */
+  cwd = g_get_current_dir ( );
+  cache_checksum_string (checksum, cwd);
+  g_free (cwd);
+
+  for ( i = 0; i < (guint) argc; i++ )
+    cache_checksum_string (checksum, argv[i]);
+
+  /* PKG_CONFIG_* (including the per-package variable overrides) and the
+   * compiler include paths; sorted so the order in environ is irrelevant */
+  env = g_ptr_array_new ( );
+  for ( iter = environ; *iter != NULL; iter++ )
+    {
+      if ( cache_env_relevant (*iter) )
+        g_ptr_array_add (env, *iter);
+    }
+
+  g_ptr_array_sort (env, (GCompareFunc) g_strcmp0);
+  cache_checksum_string (checksum, "env");
+
+  for ( i = 0; i < env->len; i++ )
+    cache_checksum_string (checksum, g_ptr_array_index (env, i));
+
+  g_ptr_array_free (env, TRUE);
+
+  /* pkg-config.pc contents */
+  path = file_build_path (PKG_CONFIG_PACKAGE_PATH, "pkg-config");
+  cache_checksum_string (checksum, path);
+
+  if ( g_file_get_contents (path, &contents, &length, NULL) )
+    {
+      g_checksum_update (checksum, (const guchar *) contents, length);
+      g_free (contents);
+    }
+
+  g_free (path);
+
+  key = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+
+  return key;
+}
+
+/* ATTN: Returns the position after the line or NULL when it's malformed */
+static char *
+cache_parse_input (char *p, Input *input)
+{
+  char type;
+  char *end;
+
+  type = *p;
+  if ( (type != 'f' && type != 'd') || p[1] != ' ' )
+    return NULL;
+
+  input->is_dir = type == 'd';
+  input->exists = (gboolean) g_ascii_strtoll (p + 2, &end, 10);
+  input->mtime = g_ascii_strtoll (end, &end, 10);
+  input->size = g_ascii_strtoll (end, &end, 10);
+
+  if ( *end++ != ' ' )
+    return NULL;
+
+  input->path = end;
+
+  end = strchr (end, '\n');
+  if ( end == NULL )
+    return NULL;
+
+  *end = '\0';
+  return end + 1;
+}
+
+/* ATTN: Returns TRUE when the entry is valid and all its inputs are current */
+static gboolean
+cache_replay (char *entry, gsize entry_len, int *status)
+{
+  Input input;
+  char *p, *end;
+  gsize length;
+
+  p = entry;
+
+  if ( strncmp (p, CACHE_MAGIC "\nstatus ", sizeof (CACHE_MAGIC "\nstatus ") - 1) != 0 )
+    return FALSE;
+
+  p += sizeof (CACHE_MAGIC "\nstatus ") - 1;
+  *status = (int) g_ascii_strtoll (p, &end, 10);
+
+  if ( *end++ != '\n' )
+    return FALSE;
+
+  for ( p = end; strncmp (p, "input ", 6) == 0; )
+    {
+      p = cache_parse_input (p + 6, &input);
+      if ( p == NULL )
+        return FALSE;
+
+      if ( !input_is_current (&input) )
+        {
+          debug_spew ("Cache entry is stale: '%s' changed\n", input.path);
+          return FALSE;
+        }
+    }
+
+  if ( strncmp (p, "output ", 7) != 0 )
+    return FALSE;
+
+  length = g_ascii_strtoull (p + 7, &end, 10);
+  if ( *end++ != '\n' || end + length != entry + entry_len )
+    return FALSE;
+
+  probe1 (cache__hit, length);
+
+  fwrite (end, 1, length, stdout);
+  fflush (stdout);
+
+  return TRUE;
+}
+
+gboolean
+cache_lookup (int argc, char **argv, int *status)
+{
+  char *path;
+  char *entry;
+  gsize length;
+  gboolean hit;
+  int i;
+
+  cache_dir = getenv ("PKG_CONFIG_CACHE_DIR");
+  if ( cache_dir == NULL || *cache_dir == '\0' )
+    return FALSE;
+
+  /* Side effects and diagnostics can't be replayed */
+  if ( getenv ("PKG_CONFIG_DEBUG_SPEW") != NULL ||
+       getenv ("PKG_CONFIG_LOG") != NULL )
+    return FALSE;
+
+  for ( i = 1; i < argc; i++ )
+    {
+      if ( strcmp (argv[i], "--debug") == 0 )
+        return FALSE;
+    }
+
+  cache_key = cache_compute_key (argc, argv);
+  cache_enabled = TRUE;
+
+  path = g_build_filename (cache_dir, cache_key, NULL);
+  hit = FALSE;
+
+  if ( g_file_get_contents (path, &entry, &length, NULL) )
+    {
+      hit = cache_replay (entry, length, status);
+      g_free (entry);
+    }
+
+  g_free (path);
+
+  if ( hit )
+    {
+      g_free (cache_key);
+      cache_key = NULL;
+    }
+
+  return hit;
+}
+
+void
+cache_begin (void)
+{
+  if ( !cache_enabled )
+    return;
+
+  if ( !capture_start ( ) )
+    {
+      cache_enabled = FALSE;
+      return;
+    }
+
+  inputs_enable ( );
+}
+
+static void
+cache_store (int status, const char *output, gsize length)
+{
+  GList *iter;
+  Input *input;
+  FILE *f;
+  char *path;
+  char *tmp;
+
+  if ( g_mkdir_with_parents (cache_dir, 0755) != 0 )
+    return;
+
+  path = g_build_filename (cache_dir, cache_key, NULL);
+  tmp = g_strdup_printf ("%s.%d.tmp", path, (int) getpid ( ));
+
+  f = fopen (tmp, "w");
+  if ( f == NULL )
+    goto quit;
+
+  fprintf (f, CACHE_MAGIC "\nstatus %d\n", status);
+
+  for ( iter = inputs_get ( ); iter != NULL; iter = iter->next )
+    {
+      input = iter->data;
+
+      /* The entry format is line based */
+      if ( strchr (input->path, '\n') != NULL )
+        {
+          fclose (f);
+          unlink (tmp);
+          goto quit;
+        }
+
+      fprintf (f, "input %c %d %" G_GINT64_FORMAT " %" G_GINT64_FORMAT " %s\n",
+               input->is_dir ? 'd' : 'f', input->exists,
+               input->mtime, input->size, input->path);
+    }
+
+  fprintf (f, "output %lu\n", (unsigned long) length);
+  fwrite (output, 1, length, f);
+
+  /* Publish atomically; concurrent writers of the same key race harmlessly */
+  if ( fclose (f) != 0 || rename (tmp, path) != 0 )
+    unlink (tmp);
+
+quit:
+
+  g_free (tmp);
+  g_free (path);
+}
+
+/* Store the answer printed by the query, which the caller got from
+ * capture_finish */
+void
+cache_end (int status, const char *output, gsize length)
+{
+  if ( output != NULL && cache_enabled && cache_key != NULL )
+    cache_store (status, output, length);
+
+  g_free (cache_key);
+  cache_key = NULL;
+  cache_enabled = FALSE;
+}
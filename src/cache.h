@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+#include <glib.h>
+
+
+/* Query result cache: a stored answer is replayed verbatim when the same
+ * query is asked again and none of the inputs it consulted changed. */
+
+gboolean cache_lookup (int argc, char **argv, int *status);
+
+void cache_begin (void);
+void cache_end (int status, const char *output, gsize length);
+
+void cache_disable (void);
+gboolean cache_env_relevant (const char *entry);
+
+
+#endif  /* _CACHE_H_ */
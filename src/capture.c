@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "capture.h"
+
+
+static FILE *capture = NULL;
+static int saved_stdout = -1;
+
+
+/*
+ * Code
+ */
+
+/* Start capturing; does nothing when already capturing
+ * ATTN: Returns FALSE when stdout couldn't be diverted */
+gboolean
+capture_start (void)
+{
+  if ( capture != NULL )
+    return TRUE;
+
+  fflush (stdout);
+
+  capture = tmpfile ( );
+  if ( capture != NULL )
+    saved_stdout = dup (STDOUT_FILENO);
+
+  if ( saved_stdout < 0 || dup2 (fileno (capture), STDOUT_FILENO) < 0 )
+    {
+      if ( capture != NULL )
+        fclose (capture);
+
+      if ( saved_stdout >= 0 )
+        close (saved_stdout);
+
+      capture = NULL;
+      saved_stdout = -1;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Put the real stdout back and hand it whatever the query printed. The
+ * captured bytes are returned as well (NULL when nothing was captured) */
+char *
+capture_finish (gsize *length)
+{
+  char *output;
+  long size;
+
+  *length = 0;
+
+  if ( capture == NULL )
+    return NULL;
+
+  fflush (stdout);
+  dup2 (saved_stdout, STDOUT_FILENO);
+  close (saved_stdout);
+  saved_stdout = -1;
+
+  size = ftell (capture);
+  output = g_malloc (size > 0 ? size : 1);
+
+  rewind (capture);
+  *length = fread (output, 1, size > 0 ? size : 0, capture);
+
+  fclose (capture);
+  capture = NULL;
+
+  fwrite (output, 1, *length, stdout);
+  fflush (stdout);
+
+  return output;
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _CAPTURE_H_
+#define _CAPTURE_H_
+
+#include <glib.h>
+
+
+/* Stdout of the query is diverted to a temporary file while it runs, for
+ * the result cache to store it and for the journal to measure it; it is
+ * written to the real stdout when the capture finishes. */
+
+gboolean capture_start (void);
+char * capture_finish (gsize *length);
+
+
+#endif  /* _CAPTURE_H_ */
@@ -116,18 +116,18 @@ cflag_init_system_dirs (Package *pkg_config)
 void
 cflags_verify ( Package *pkg, Package *config )
 {
-  Flag *flag;
   char *cflags;
-  GList *iter;
+  char *arg;
+  guint i;
 
-  for ( iter = pkg->cflags.items; iter != NULL; )
+  for ( i = 0; i < pkg->cflags.len; )
     {
-      flag = iter->data;
+      arg = pkg->cflags.args[i];
 
-      if ( !(flag->type & CFLAGS_I) )
+      if ( !(pkg->cflags.types[i] & CFLAGS_I) )
         {
           /* Move to the next item in the list */
-          iter = iter->next;
+          i++;
           continue;
         }
 
@@ -140,12 +140,12 @@ cflags_verify ( Package *pkg, Package *config )
        */
 
       /* Check '-I' first. */
-      cflags = flag->arg;
+      cflags = arg;
       if ( *cflags++ != '-' || /* An empty string or doesn't begin w/ '-' character */
            *cflags++ != 'I' )  /* "-" string or doesn't begin w/ "-I" */
         {
           /* Move to the next item in the list */
-          iter = iter->next;
+          i++;
           continue;
         }
 
@@ -153,24 +153,18 @@ cflags_verify ( Package *pkg, Package *config )
       if ( *cflags == ' ' )
         cflags++;
 
-      if ( !cflag_is_system_dirs ( cflags, pkg->key, flag->arg ) )
+      if ( !cflag_is_system_dirs ( cflags, pkg->key, arg ) )
         {
           /* Move to the next item in the list */
-          iter = iter->next;
+          i++;
           continue;
         }
 
-      debug_spew ("Removing %s from Cflags for %s\n", flag->arg, pkg->key);
-
-      /* Remove the current item from the list including freeing the memory. Please note the
-       * pointer to the list is changed when it's the first item in the list. Then we move to
-       * the next item. */
-      iter = tail_list_remove (&pkg->cflags, iter);
+      debug_spew ("Removing %s from Cflags for %s\n", arg, pkg->key);
 
-#if !GLIB_CHECK_VERSION(2,28,0)
-      /* Don't forget to destroy flag object */
-      free_flag (flag);
-#endif
+      /* Remove the current item including freeing the memory; the next item
+       * moves to the same index */
+      flag_set_remove (&pkg->cflags, i);
     }
 }
 
@@ -196,7 +190,6 @@ static gboolean
 cflags_do_parse (Package *pkg, int argc, char **argv)
 {
   int i;
-  Flag *flag;
   FlagType type;
   char *tmp, *arg, *p;
   char *newarg;
@@ -207,9 +200,8 @@ cflags_do_parse (Package *pkg, int argc, char **argv)
       if (tmp == NULL)
         return TRUE;
 
-      arg = s_dup_escape_shell (tmp);
+      arg = s_escape_shell (tmp);
       p = arg;
-      g_free (tmp);
 
       if ( p[0] == '-' &&
            p[1] == 'I' )
@@ -231,8 +223,7 @@ cflags_do_parse (Package *pkg, int argc, char **argv)
               return TRUE;
             }
 
-          p = s_dup_escape_shell (tmp);
-          g_free (tmp);
+          p = s_escape_shell (tmp);
 
           /* These are -I flags since they control the search path */
           type = CFLAGS_I;
@@ -250,8 +241,7 @@ cflags_do_parse (Package *pkg, int argc, char **argv)
           continue;
         }
 
-      flag = flag_create (type, newarg);
-      tail_list_add (&pkg->cflags, flag);
+      flag_set_add (&pkg->cflags, type, newarg);
     }
 
   return FALSE;
@@ -267,7 +257,7 @@ cflags_parse (Package *pkg, Package *config, const char *str, const char *path)
   GError *error = NULL;
   gboolean die;
 
-  if ( pkg->cflags.items != NULL )
+  if ( pkg->cflags.len > 0 )
     {
       verbose_error ("Cflags field occurs twice in '%s'\n", path);
 
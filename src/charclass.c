@@ -0,0 +1,362 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "charclass.h"
+
+/* The vector scans load whole aligned blocks around the string, which
+ * AddressSanitizer reports as out of bounds; builds with it use the table */
+#if defined(__SANITIZE_ADDRESS__)
+  #define CC_SANITIZE 1
+#elif defined(__has_feature)
+  #if __has_feature(address_sanitizer)
+    #define CC_SANITIZE 1
+  #endif
+#endif
+
+#ifndef CC_SANITIZE
+  #define CC_SANITIZE 0
+#endif
+
+#if defined(__GNUC__) && defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__)) && !CC_SANITIZE
+  #define CC_X86 1
+  #include <immintrin.h>
+#else
+  #define CC_X86 0
+#endif
+
+
+#define S  CC_SPACE
+#define V  CC_VALID
+#define M  CC_MODULE_SEP
+#define E  CC_ESCAPE
+#define O  CC_OPERATOR
+
+const guint8 char_class[256] =
+{
+  E, E, E, E, E, E, E, E, E, S|M|E, S|M|E, S|M|E, S|M|E, S|M|E, E, E,
+  E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,
+  S|M|E, E|O, E, E, 0, E, E, E, 0, 0, E, 0, M, 0, V, 0,
+  V, V, V, V, V, V, V, V, V, V, 0, E, E|O, O, E|O, E,
+  0, V, V, V, V, V, V, V, V, V, V, V, V, V, V, V,
+  V, V, V, V, V, V, V, V, V, V, V, E, E, E, 0, V,
+  E, V, V, V, V, V, V, V, V, V, V, V, V, V, V, V,
+  V, V, V, V, V, V, V, V, V, V, V, E, E, E, 0, E,
+  E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,
+  E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,
+  E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,
+  E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,
+  E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,
+  E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,
+  E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,
+  E, E, E, E, E, E, E, E, E, E, E, E, E, E, E, E,
+};
+
+#undef S
+#undef V
+#undef M
+#undef E
+#undef O
+
+
+typedef enum
+{
+  SKIP_SPACE,
+  FIND_SPACE,
+  FIND_MODULE_SEP,
+  FIND_END_BRACKET,
+  FIND_ESCAPE
+} Scan;
+
+typedef const char * (*Scanner) (const char *p, Scan scan);
+
+
+/*
+ * Code
+ */
+
+static inline gboolean
+scan_stops (char c, Scan scan)
+{
+  switch (scan)
+    {
+      case SKIP_SPACE:
+        return !CC_IS (c, CC_SPACE);
+
+      case FIND_SPACE:
+        return c == '\0' || CC_IS (c, CC_SPACE);
+
+      case FIND_MODULE_SEP:
+        return c == '\0' || CC_IS (c, CC_MODULE_SEP);
+
+      case FIND_END_BRACKET:
+        return c == '\0' || c == '}';
+
+      default:
+        /* NUL is in the escape class */
+        return CC_IS (c, CC_ESCAPE);
+    }
+}
+
+#if CC_X86
+
+/* Vector versions. Each load reads a whole aligned block, so it may read
+ * up to 15 (SSE2) or 31 (AVX2) bytes in front of the string and behind
+ * its NUL. Those bytes are outside the allocation, but an aligned block
+ * never crosses a page boundary, so they're on a page the string itself
+ * is on and the read can't fault. Bytes in front of the string are
+ * masked off and the scan stops at the NUL, so they never affect the
+ * result. Memory checkers see the reads, though: AddressSanitizer builds
+ * use the table instead (see CC_SANITIZE), and valgrind needs
+ * --partial-loads-ok=yes. */
+
+#define SSE2_IN_RANGE(v, lo, hi) \
+  _mm_cmpeq_epi8 (_mm_min_epu8 (_mm_sub_epi8 ((v), _mm_set1_epi8 (lo)), _mm_set1_epi8 ((hi) - (lo))), \
+                  _mm_sub_epi8 ((v), _mm_set1_epi8 (lo)))
+
+static inline __m128i
+sse2_space (__m128i v)
+{
+  return _mm_or_si128 (SSE2_IN_RANGE (v, '\t', '\r'), _mm_cmpeq_epi8 (v, _mm_set1_epi8 (' ')));
+}
+
+/* Bytes that can go to the shell as they are */
+static inline __m128i
+sse2_safe (__m128i v)
+{
+  __m128i safe;
+
+  safe = _mm_or_si128 (SSE2_IN_RANGE (v, '+', ':'), SSE2_IN_RANGE (v, '@', 'Z'));
+  safe = _mm_or_si128 (safe, SSE2_IN_RANGE (v, 'a', 'z'));
+  safe = _mm_or_si128 (safe, SSE2_IN_RANGE (v, '(', ')'));
+  safe = _mm_or_si128 (safe, SSE2_IN_RANGE (v, '^', '_'));
+  safe = _mm_or_si128 (safe, _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('$')));
+  safe = _mm_or_si128 (safe, _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('=')));
+  safe = _mm_or_si128 (safe, _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('~')));
+
+  return safe;
+}
+
+/* Mask of the bytes that stop the scan */
+static inline unsigned int
+sse2_stop (__m128i v, Scan scan)
+{
+  __m128i nul = _mm_cmpeq_epi8 (v, _mm_setzero_si128 ( ));
+  __m128i hit;
+
+  switch (scan)
+    {
+      case SKIP_SPACE:
+        /* Stops at anything but a space, NUL included */
+        return ~_mm_movemask_epi8 (sse2_space (v)) & 0xffff;
+
+      case FIND_SPACE:
+        hit = sse2_space (v);
+        break;
+
+      case FIND_MODULE_SEP:
+        hit = _mm_or_si128 (sse2_space (v), _mm_cmpeq_epi8 (v, _mm_set1_epi8 (',')));
+        break;
+
+      case FIND_END_BRACKET:
+        hit = _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('}'));
+        break;
+
+      default:
+        /* NUL isn't safe */
+        return ~_mm_movemask_epi8 (sse2_safe (v)) & 0xffff;
+    }
+
+  return _mm_movemask_epi8 (_mm_or_si128 (nul, hit));
+}
+
+static const char *
+scan_sse2 (const char *p, Scan scan)
+{
+  const char *block;
+  unsigned int mask;
+
+  /* Aligned, so within the page of p; see above */
+  block = (const char *) ((guintptr) p & ~(guintptr) 15);
+  mask = sse2_stop (_mm_load_si128 ((const __m128i *) block), scan);
+  mask &= 0xffffu << (p - block);
+
+  while ( mask == 0 )
+    {
+      block += 16;
+      mask = sse2_stop (_mm_load_si128 ((const __m128i *) block), scan);
+    }
+
+  return block + __builtin_ctz (mask);
+}
+
+#define AVX2_IN_RANGE(v, lo, hi) \
+  _mm256_cmpeq_epi8 (_mm256_min_epu8 (_mm256_sub_epi8 ((v), _mm256_set1_epi8 (lo)), _mm256_set1_epi8 ((hi) - (lo))), \
+                     _mm256_sub_epi8 ((v), _mm256_set1_epi8 (lo)))
+
+__attribute__ ((target ("avx2"))) static inline __m256i
+avx2_space (__m256i v)
+{
+  return _mm256_or_si256 (AVX2_IN_RANGE (v, '\t', '\r'), _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 (' ')));
+}
+
+__attribute__ ((target ("avx2"))) static inline __m256i
+avx2_safe (__m256i v)
+{
+  __m256i safe;
+
+  safe = _mm256_or_si256 (AVX2_IN_RANGE (v, '+', ':'), AVX2_IN_RANGE (v, '@', 'Z'));
+  safe = _mm256_or_si256 (safe, AVX2_IN_RANGE (v, 'a', 'z'));
+  safe = _mm256_or_si256 (safe, AVX2_IN_RANGE (v, '(', ')'));
+  safe = _mm256_or_si256 (safe, AVX2_IN_RANGE (v, '^', '_'));
+  safe = _mm256_or_si256 (safe, _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 ('$')));
+  safe = _mm256_or_si256 (safe, _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 ('=')));
+  safe = _mm256_or_si256 (safe, _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 ('~')));
+
+  return safe;
+}
+
+__attribute__ ((target ("avx2"))) static inline unsigned int
+avx2_stop (__m256i v, Scan scan)
+{
+  __m256i nul = _mm256_cmpeq_epi8 (v, _mm256_setzero_si256 ( ));
+  __m256i hit;
+
+  switch (scan)
+    {
+      case SKIP_SPACE:
+        return ~(unsigned int) _mm256_movemask_epi8 (avx2_space (v));
+
+      case FIND_SPACE:
+        hit = avx2_space (v);
+        break;
+
+      case FIND_MODULE_SEP:
+        hit = _mm256_or_si256 (avx2_space (v), _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 (',')));
+        break;
+
+      case FIND_END_BRACKET:
+        hit = _mm256_cmpeq_epi8 (v, _mm256_set1_epi8 ('}'));
+        break;
+
+      default:
+        return ~(unsigned int) _mm256_movemask_epi8 (avx2_safe (v));
+    }
+
+  return (unsigned int) _mm256_movemask_epi8 (_mm256_or_si256 (nul, hit));
+}
+
+__attribute__ ((target ("avx2"))) static const char *
+scan_avx2 (const char *p, Scan scan)
+{
+  const char *block;
+  unsigned int mask;
+
+  /* Aligned, so within the page of p; see above */
+  block = (const char *) ((guintptr) p & ~(guintptr) 31);
+  mask = avx2_stop (_mm256_load_si256 ((const __m256i *) block), scan);
+  mask &= 0xffffffffu << (p - block);
+
+  while ( mask == 0 )
+    {
+      block += 32;
+      mask = avx2_stop (_mm256_load_si256 ((const __m256i *) block), scan);
+    }
+
+  return block + __builtin_ctz (mask);
+}
+
+#else
+
+static const char *
+scan_table (const char *p, Scan scan)
+{
+  while ( !scan_stops (*p, scan) )
+    p++;
+
+  return p;
+}
+
+#endif // CC_X86
+
+static const char *
+scan_dispatch (const char *p, Scan scan);
+
+static Scanner scanner = scan_dispatch;
+
+/* Pick the widest implementation on first use */
+static const char *
+scan_dispatch (const char *p, Scan scan)
+{
+#if CC_X86
+  __builtin_cpu_init ( );
+
+  if ( __builtin_cpu_supports ("avx2") )
+    scanner = scan_avx2;
+  else
+    scanner = scan_sse2;
+#else
+  scanner = scan_table;
+#endif
+
+  return scanner (p, scan);
+}
+
+/* Most scans stop within a few bytes; only go wide when the first bytes
+ * don't settle it */
+static const char *
+cc_scan (const char *p, Scan scan)
+{
+  int i;
+
+  for ( i = 0; i < 8; i++, p++ )
+    if ( scan_stops (*p, scan) )
+      return p;
+
+  return scanner (p, scan);
+}
+
+const char *
+cc_skip_space (const char *p)
+{
+  return cc_scan (p, SKIP_SPACE);
+}
+
+const char *
+cc_find_space (const char *p)
+{
+  return cc_scan (p, FIND_SPACE);
+}
+
+const char *
+cc_find_module_sep (const char *p)
+{
+  return cc_scan (p, FIND_MODULE_SEP);
+}
+
+const char *
+cc_find_end_bracket (const char *p)
+{
+  return cc_scan (p, FIND_END_BRACKET);
+}
+
+const char *
+cc_find_escape (const char *p)
+{
+  return cc_scan (p, FIND_ESCAPE);
+}
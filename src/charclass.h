@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _CHARCLASS_H_
+#define _CHARCLASS_H_
+
+#include <glib.h>
+
+
+/* Character classes of the .pc parser, locale independent */
+#define CC_SPACE      (1 << 0)  /* ' ', '\t', '\n', '\v', '\f', '\r' */
+#define CC_VALID      (1 << 1)  /* letters, digits, '_' and '.' */
+#define CC_MODULE_SEP (1 << 2)  /* ',' and spaces */
+#define CC_ESCAPE     (1 << 3)  /* needs a '\' in front for the shell */
+#define CC_OPERATOR   (1 << 4)  /* '<', '>', '!' and '=' */
+
+extern const guint8 char_class[256];
+
+#define CC_IS(c, cls)  (char_class[(guchar) (c)] & (cls))
+
+
+/* Scanners over a NUL terminated string, returning a pointer to the first
+ * matching byte or to the terminating NUL. They use SSE2 or AVX2 when the
+ * CPU has it. */
+const char * cc_skip_space (const char *p);
+const char * cc_find_space (const char *p);
+const char * cc_find_module_sep (const char *p);
+const char * cc_find_end_bracket (const char *p);
+const char * cc_find_escape (const char *p);
+
+
+#endif  /* _CHARCLASS_H_ */
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <string.h>
+
+#include "depfile.h"
+#include "inputs.h"
+#include "utils.h"
+
+
+/* The file is written when the query is done:
+ *
+ *   TARGET: \
+ *    /usr/lib/pkgconfig/foo.pc \
+ *    /usr/lib/pkgconfig
+ *
+ * TARGET is the name given with --depfile-target, or the depfile itself.
+ * Only inputs that exist are listed: Make refuses prerequisites it can't
+ * build and Ninja would consider the query out of date forever. A missing
+ * .pc file is covered by the directories it was looked for in, whose
+ * modification time changes when a file is added. */
+
+static char *depfile_path = NULL;
+static char *depfile_target = NULL;
+
+
+/*
+ * Code
+ */
+
+/* Record the inputs from the start when the option is on the command line:
+ * pkg-config.pc is read before the options are parsed */
+void
+depfile_begin (int argc, char **argv)
+{
+  int i;
+
+  for ( i = 1; i < argc; i++ )
+    {
+      if ( strcmp (argv[i], "--") == 0 )
+        break;
+
+      if ( strcmp (argv[i], "--depfile") == 0 || strncmp (argv[i], "--depfile=", 10) == 0 )
+        {
+          inputs_enable ( );
+          break;
+        }
+    }
+}
+
+void
+depfile_start (const char *path)
+{
+  g_free (depfile_path);
+  depfile_path = g_strdup (path);
+
+  inputs_enable ( );
+}
+
+void
+depfile_set_target (const char *target)
+{
+  g_free (depfile_target);
+  depfile_target = g_strdup (target);
+}
+
+/* Escape a path for both Make and Ninja */
+static void
+depfile_append_path (GString *out, const char *path)
+{
+  const char *p;
+
+  for ( p = path; *p != '\0'; p++ )
+    {
+      if ( *p == ' ' || *p == '#' )
+        g_string_append_c (out, '\\');
+      else if ( *p == '$' )
+        g_string_append_c (out, '$');
+
+      g_string_append_c (out, *p);
+    }
+}
+
+void
+depfile_finish (void)
+{
+  GString *out;
+  GError *error = NULL;
+  GList *iter;
+  Input *input;
+
+  if ( depfile_path == NULL )
+    return;
+
+  out = g_string_new (NULL);
+
+  depfile_append_path (out, depfile_target != NULL ? depfile_target : depfile_path);
+  g_string_append_c (out, ':');
+
+  for ( iter = inputs_get ( ); iter != NULL; iter = iter->next )
+    {
+      input = iter->data;
+      if ( !input->exists )
+        continue;
+
+      g_string_append (out, " \\\n ");
+      depfile_append_path (out, input->path);
+    }
+
+  g_string_append_c (out, '\n');
+
+  /* Readers never see a partial file */
+  if ( !g_file_set_contents (depfile_path, out->str, out->len, &error) )
+    {
+      spew ("Cannot write depfile: %s\n", error->message);
+      g_clear_error (&error);
+    }
+
+  g_string_free (out, TRUE);
+
+  g_free (depfile_path);
+  g_free (depfile_target);
+  depfile_path = NULL;
+  depfile_target = NULL;
+}
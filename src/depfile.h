@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _DEPFILE_H_
+#define _DEPFILE_H_
+
+#include <glib.h>
+
+
+/* --depfile=FILE writes the .pc files and search directories the answer
+ * was derived from as a Make/Ninja dependency file, so a build system
+ * only asks again when one of them changes. */
+
+void depfile_begin (int argc, char **argv);
+void depfile_start (const char *path);
+void depfile_set_target (const char *target);
+void depfile_finish (void);
+
+
+#endif  /* _DEPFILE_H_ */
@@ -0,0 +1,417 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <string.h>
+
+#include "export.h"
+#include "flag.h"
+#include "globals.h"
+#include "graph.h"
+#include "reqver.h"
+
+
+/*
+ * For every package of the closure, dependencies first:
+ *
+ * cmake  an INTERFACE IMPORTED target PkgConfig::<name> with the compile
+ *        flags --cflags prints for the package and its own link flags.
+ *        Its Requires are linked targets, and so is Requires.private
+ *        with --static; CMake drops the compile flags found twice.
+ *        PKG_<NAME>_VERSION, _REQUIRES and _REQUIRES_PRIVATE (lists of
+ *        package names) are set as well.
+ *
+ * make,  PKG_<NAME>_VERSION, _REQUIRES and _REQUIRES_PRIVATE (package
+ * ninja  names), _OWN_CFLAGS and _OWN_LIBS (flags of the package itself)
+ *        and _CFLAGS and _LIBS: what --cflags and --libs print for the
+ *        package, requirements included.
+ *
+ * <NAME> is the package name upper cased with anything but letters and
+ * digits turned into underscores.
+ */
+
+typedef enum
+{
+  EXPORT_CMAKE = 1,
+  EXPORT_MAKE,
+  EXPORT_NINJA
+} ExportFormat;
+
+static ExportFormat export_format = 0;
+
+
+/*
+ * Code
+ */
+
+gboolean
+export_set_format (const char *name)
+{
+  if ( strcmp (name, "cmake") == 0 )
+    export_format = EXPORT_CMAKE;
+  else if ( strcmp (name, "make") == 0 )
+    export_format = EXPORT_MAKE;
+  else if ( strcmp (name, "ninja") == 0 )
+    export_format = EXPORT_NINJA;
+  else
+    return FALSE;
+
+  return TRUE;
+}
+
+static char *
+export_var_name (const Package *pkg, const char *suffix)
+{
+  char *name;
+  char *p;
+
+  name = g_strconcat ("PKG_", pkg->key, "_", suffix, NULL);
+
+  for ( p = name; *p != '\0'; p++ )
+    *p = g_ascii_isalnum (*p) ? g_ascii_toupper (*p) : '_';
+
+  return name;
+}
+
+/* Target names allow a few more characters than variable names */
+static char *
+export_target_name (const Package *pkg)
+{
+  char *name;
+  char *p;
+
+  name = g_strconcat ("PkgConfig::", pkg->key, NULL);
+
+  for ( p = name + strlen ("PkgConfig::"); *p != '\0'; p++ )
+    {
+      if ( !g_ascii_isalnum (*p) && strchr ("_.+-", *p) == NULL )
+        *p = '_';
+    }
+
+  return name;
+}
+
+/* The flags of the package alone, in file order */
+static char *
+export_own_flags (Package *pkg, FlagType type)
+{
+  GList list = { pkg, NULL, NULL };
+  GArray *flags;
+  char *str;
+
+  flags = flag_merge_lists (&list, type);
+  str = flag_list_to_string (flags);
+  g_array_free (flags, TRUE);
+
+  return g_strchomp (str);
+}
+
+/* The flags of the package with its requirements, like --cflags/--libs */
+static char *
+export_flags (Package *pkg, FlagType type)
+{
+  GList list = { pkg, NULL, NULL };
+
+  return flags_packages_get (&list, type);
+}
+
+/* Add the names of the Requires or Requires.private of a package */
+static void
+export_requires (GPtrArray *names, Package *pkg, gboolean private)
+{
+  const guint *edges;
+  guint count;
+  guint i;
+  Package *req;
+
+  edges = graph_edges (pkg, &count);
+
+  for ( i = 0; i < count; i++ )
+    {
+      if ( GRAPH_EDGE_PRIVATE (edges[i]) != private )
+        continue;
+
+      if ( private && graph_requires_public (pkg, GRAPH_EDGE_TARGET (edges[i])) )
+        continue;
+
+      req = graph_node (GRAPH_EDGE_TARGET (edges[i]));
+      if ( req != NULL )
+        g_ptr_array_add (names, req);
+    }
+}
+
+/*
+ * CMake
+ */
+
+/* Append a string to a quoted CMake argument. The escapes of '$' and ';'
+ * only leave them literal: generator expressions and escaped list
+ * separators keep working */
+static void
+export_append_cmake_escaped (GString *out, const char *str)
+{
+  const char *p;
+
+  for ( p = str; *p != '\0'; p++ )
+    {
+      if ( strchr ("\\\"$;", *p) != NULL )
+        g_string_append_c (out, '\\');
+      g_string_append_c (out, *p);
+    }
+}
+
+/* Add the words of a string of shell words to a CMake list; takes
+ * ownership of the string */
+static void
+export_cmake_words (GPtrArray *items, char *words)
+{
+  char **argv = NULL;
+  int argc = 0;
+  int i;
+
+  if ( *words != '\0' && g_shell_parse_argv (words, &argc, &argv, NULL) )
+    {
+      for ( i = 0; i < argc; i++ )
+        g_ptr_array_add (items, argv[i]);
+
+      /* The strings are owned by the array now */
+      g_free (argv);
+    }
+
+  g_free (words);
+}
+
+/* Add the targets, or names, of the Requires or Requires.private */
+static void
+export_cmake_requires (GPtrArray *items, Package *pkg, gboolean private, gboolean targets)
+{
+  GPtrArray *requires;
+  Package *req;
+  guint i;
+
+  requires = g_ptr_array_new ( );
+  export_requires (requires, pkg, private);
+
+  for ( i = 0; i < requires->len; i++ )
+    {
+      req = g_ptr_array_index (requires, i);
+      g_ptr_array_add (items, targets ? export_target_name (req) : g_strdup (req->key));
+    }
+
+  g_ptr_array_free (requires, TRUE);
+}
+
+static void
+export_cmake_set (GString *out, Package *pkg, const char *suffix, GPtrArray *items)
+{
+  char *name;
+  guint i;
+
+  name = export_var_name (pkg, suffix);
+  g_string_append_printf (out, "set(%s \"", name);
+
+  for ( i = 0; i < items->len; i++ )
+    {
+      if ( i > 0 )
+        g_string_append_c (out, ';');
+      export_append_cmake_escaped (out, g_ptr_array_index (items, i));
+    }
+
+  g_string_append (out, "\")\n");
+  g_free (name);
+}
+
+static void
+export_cmake_property (GString *out, const char *property, GPtrArray *items)
+{
+  guint i;
+
+  g_string_append_printf (out, "\n  %s \"", property);
+
+  for ( i = 0; i < items->len; i++ )
+    {
+      if ( i > 0 )
+        g_string_append_c (out, ';');
+      export_append_cmake_escaped (out, g_ptr_array_index (items, i));
+    }
+
+  g_string_append_c (out, '"');
+}
+
+static void
+export_cmake_package (GString *out, Package *pkg)
+{
+  GPtrArray *items;
+  char *target;
+
+  target = export_target_name (pkg);
+
+  g_string_append_printf (out, "\nif(NOT TARGET %s)\n"
+                          "  add_library(%s INTERFACE IMPORTED)\n"
+                          "endif()\n"
+                          "set_target_properties(%s PROPERTIES",
+                          target, target, target);
+
+  items = g_ptr_array_new_with_free_func (g_free);
+  export_cmake_words (items, export_flags (pkg, CFLAGS_ANY));
+  export_cmake_property (out, "INTERFACE_COMPILE_OPTIONS", items);
+
+  g_ptr_array_set_size (items, 0);
+  export_cmake_words (items, export_own_flags (pkg, LIBS_ANY));
+  export_cmake_requires (items, pkg, FALSE, TRUE);
+  if ( !ignore_private_libs )
+    export_cmake_requires (items, pkg, TRUE, TRUE);
+  export_cmake_property (out, "INTERFACE_LINK_LIBRARIES", items);
+  g_string_append (out, ")\n");
+
+  g_ptr_array_set_size (items, 0);
+  g_ptr_array_add (items, g_strdup (pkg->version));
+  export_cmake_set (out, pkg, "VERSION", items);
+
+  g_ptr_array_set_size (items, 0);
+  export_cmake_requires (items, pkg, FALSE, FALSE);
+  export_cmake_set (out, pkg, "REQUIRES", items);
+
+  g_ptr_array_set_size (items, 0);
+  export_cmake_requires (items, pkg, TRUE, FALSE);
+  export_cmake_set (out, pkg, "REQUIRES_PRIVATE", items);
+
+  g_ptr_array_free (items, TRUE);
+  g_free (target);
+}
+
+/*
+ * make and ninja
+ */
+
+/* Both need '$' doubled; make also needs '#' escaped */
+static void
+export_append_value (GString *out, const char *value)
+{
+  const char *p;
+
+  for ( p = value; *p != '\0'; p++ )
+    {
+      if ( *p == '$' )
+        g_string_append_c (out, '$');
+      else if ( *p == '#' && export_format == EXPORT_MAKE )
+        g_string_append_c (out, '\\');
+      else if ( *p == '\n' )
+        continue;
+
+      g_string_append_c (out, *p);
+    }
+}
+
+static void
+export_var (GString *out, Package *pkg, const char *suffix, const char *value)
+{
+  char *name;
+
+  name = export_var_name (pkg, suffix);
+  g_string_append_printf (out, "%s %s", name, export_format == EXPORT_MAKE ? ":=" : "=");
+
+  if ( *value != '\0' )
+    {
+      g_string_append_c (out, ' ');
+      export_append_value (out, value);
+    }
+
+  g_string_append_c (out, '\n');
+
+  g_free (name);
+}
+
+static void
+export_var_requires (GString *out, Package *pkg, const char *suffix, gboolean private)
+{
+  GPtrArray *requires;
+  GString *names;
+  guint i;
+
+  requires = g_ptr_array_new ( );
+  export_requires (requires, pkg, private);
+
+  names = g_string_new (NULL);
+  for ( i = 0; i < requires->len; i++ )
+    {
+      if ( i > 0 )
+        g_string_append_c (names, ' ');
+      g_string_append (names, ((Package *) g_ptr_array_index (requires, i))->key);
+    }
+
+  export_var (out, pkg, suffix, names->str);
+
+  g_string_free (names, TRUE);
+  g_ptr_array_free (requires, TRUE);
+}
+
+static void
+export_vars_package (GString *out, Package *pkg)
+{
+  char *flags;
+
+  g_string_append_c (out, '\n');
+
+  export_var (out, pkg, "VERSION", pkg->version);
+
+  export_var_requires (out, pkg, "REQUIRES", FALSE);
+  export_var_requires (out, pkg, "REQUIRES_PRIVATE", TRUE);
+
+  flags = export_own_flags (pkg, CFLAGS_ANY);
+  export_var (out, pkg, "OWN_CFLAGS", flags);
+  g_free (flags);
+
+  flags = export_own_flags (pkg, LIBS_ANY);
+  export_var (out, pkg, "OWN_LIBS", flags);
+  g_free (flags);
+
+  flags = export_flags (pkg, CFLAGS_ANY);
+  export_var (out, pkg, "CFLAGS", flags);
+  g_free (flags);
+
+  flags = export_flags (pkg, LIBS_ANY);
+  export_var (out, pkg, "LIBS", flags);
+  g_free (flags);
+}
+
+char *
+export_get (Package *pkg_config, GList *packages)
+{
+  GString *out;
+  GList *closure;
+  GList *iter;
+
+  out = g_string_new (NULL);
+  g_string_append_printf (out, "# Generated by pkg-config %s\n", VERSION);
+
+  /* The order puts a package before its requirements */
+  closure = g_list_reverse (graph_order (packages, TRUE));
+
+  for ( iter = closure; iter != NULL; iter = iter->next )
+    {
+      if ( export_format == EXPORT_CMAKE )
+        export_cmake_package (out, iter->data);
+      else
+        export_vars_package (out, iter->data);
+    }
+
+  g_list_free (closure);
+
+  return g_string_free (out, FALSE);
+}
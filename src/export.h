@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _EXPORT_H_
+#define _EXPORT_H_
+
+#include <glib.h>
+
+#include "package.h"
+
+
+/* --export=FORMAT: describe every package of the closure of the command
+ * line packages, with its own flags and its requirements, in a file the
+ * build system includes once */
+
+/* ATTN: Returns FALSE when the format isn't known */
+gboolean export_set_format (const char *name);
+
+/* The file for the packages of the command line in the format set */
+char *export_get (Package *pkg_config, GList *packages);
+
+
+#endif  /* _EXPORT_H_ */
@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <string.h>
+
+#include "fingerprint.h"
+#include "globals.h"
+#include "graph.h"
+#include "parse.h"
+
+
+#define FINGERPRINT_MAGIC   "pkg-config-fingerprint 1"
+
+/* What goes into the digest, in this order:
+ *
+ *  - the pkg-config version and the digest of pkg-config.pc, whose
+ *    variables override those of the packages;
+ *  - the options that change flags: --static,
+ *    --define-prefix and the prefix variable, --define-variable, the
+ *    system directories that are stripped and whether they are;
+ *  - the environment variables PKG_CONFIG_* that matter once the packages
+ *    are found (the sysroot, the top build directory, the variable
+ *    overrides and so on), not those that only change which files are
+ *    found: that's covered by the packages themselves;
+ *  - the packages of the closure sorted by name, each with its version,
+ *    its rank in the search path (it orders the -I and -L flags) and the
+ *    digest the parser took of its lines, which also covers the directory
+ *    when the flags depend on it.
+ *
+ * The files are read once, by the parser, and no flags are merged, so it
+ * costs about as much as --exists on the same packages. */
+
+extern char **environ;
+
+static const char *ignored_env_vars[] = {
+  "PKG_CONFIG_PATH=",
+  "PKG_CONFIG_LIBDIR=",
+  "PKG_CONFIG_DISABLE_UNINSTALLED=",
+  "PKG_CONFIG_CACHE_DIR=",
+  "PKG_CONFIG_JOURNAL=",
+  "PKG_CONFIG_LOG=",
+  "PKG_CONFIG_DEBUG_SPEW=",
+  "PKG_CONFIG_PREFETCH_THREADS=",
+  NULL
+};
+
+
+/*
+ * Code
+ */
+
+static void
+fingerprint_string (GChecksum *checksum, const char *str)
+{
+  /* Include the terminator so "a" "bc" and "ab" "c" differ */
+  g_checksum_update (checksum, (const guchar *) (str != NULL ? str : ""), str != NULL ? strlen (str) + 1 : 0);
+}
+
+static void
+fingerprint_int (GChecksum *checksum, gint64 value)
+{
+  char buf[32];
+
+  g_snprintf (buf, sizeof (buf), "%" G_GINT64_FORMAT, value);
+  fingerprint_string (checksum, buf);
+}
+
+static void
+fingerprint_list (GChecksum *checksum, const char *name, GList *list)
+{
+  fingerprint_string (checksum, name);
+  fingerprint_int (checksum, g_list_length (list));
+
+  for ( ; list != NULL; list = list->next )
+    fingerprint_string (checksum, list->data);
+}
+
+static gboolean
+fingerprint_env_relevant (const char *entry)
+{
+  const char **iter;
+
+  if ( strncmp (entry, "PKG_CONFIG_", 11) != 0 )
+    return FALSE;
+
+  for ( iter = ignored_env_vars; *iter != NULL; iter++ )
+    {
+      if ( strncmp (entry, *iter, strlen (*iter)) == 0 )
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static int
+fingerprint_compare_strings (gconstpointer a, gconstpointer b)
+{
+  return strcmp (*(char * const *) a, *(char * const *) b);
+}
+
+static void
+fingerprint_options (GChecksum *checksum, Package *pkg_config)
+{
+  GPtrArray *entries;
+  GHashTableIter iter;
+  gpointer key, value;
+  char **env;
+  guint i;
+
+  fingerprint_string (checksum, FINGERPRINT_MAGIC);
+  fingerprint_string (checksum, VERSION);
+
+  /* NULL for the virtual package */
+  fingerprint_string (checksum, "pkg-config.pc");
+  fingerprint_string (checksum, pkg_config->info->digest);
+
+  fingerprint_int (checksum, ignore_private_libs);
+  fingerprint_int (checksum, define_prefix);
+  fingerprint_string (checksum, prefix_variable);
+  fingerprint_int (checksum, allow_system_cflags);
+  fingerprint_int (checksum, allow_system_libs);
+#ifdef G_OS_WIN32
+  fingerprint_int (checksum, msvc_syntax);
+#endif
+
+  fingerprint_list (checksum, "cflag_system_dirs", cflag_system_dirs.items);
+  fingerprint_list (checksum, "lib_system_dirs", lib_system_dirs.items);
+
+  /* --define-variable, sorted */
+  entries = g_ptr_array_new_with_free_func (g_free);
+
+  if ( globals != NULL )
+    {
+      g_hash_table_iter_init (&iter, globals);
+      while ( g_hash_table_iter_next (&iter, &key, &value) )
+        g_ptr_array_add (entries, g_strconcat (key, "=", value, NULL));
+    }
+
+  g_ptr_array_sort (entries, fingerprint_compare_strings);
+  fingerprint_string (checksum, "define-variable");
+
+  for ( i = 0; i < entries->len; i++ )
+    fingerprint_string (checksum, g_ptr_array_index (entries, i));
+
+  g_ptr_array_free (entries, TRUE);
+
+  /* The environment, sorted so the order in environ is irrelevant */
+  entries = g_ptr_array_new ( );
+
+  for ( env = environ; *env != NULL; env++ )
+    {
+      if ( fingerprint_env_relevant (*env) )
+        g_ptr_array_add (entries, *env);
+    }
+
+  g_ptr_array_sort (entries, fingerprint_compare_strings);
+  fingerprint_string (checksum, "env");
+
+  for ( i = 0; i < entries->len; i++ )
+    fingerprint_string (checksum, g_ptr_array_index (entries, i));
+
+  g_ptr_array_free (entries, TRUE);
+}
+
+static int
+fingerprint_compare_keys (gconstpointer a, gconstpointer b)
+{
+  const Package *pkg_a = *(const Package * const *) a;
+  const Package *pkg_b = *(const Package * const *) b;
+
+  return strcmp (pkg_a->key, pkg_b->key);
+}
+
+static int
+fingerprint_compare_ints (gconstpointer a, gconstpointer b)
+{
+  return *(const int *) a - *(const int *) b;
+}
+
+static void
+fingerprint_package (GChecksum *checksum, Package *pkg, GArray *positions)
+{
+  guint rank;
+
+  fingerprint_string (checksum, pkg->key);
+  fingerprint_string (checksum, pkg->version);
+
+  /* Only the relative order in the search path matters */
+  for ( rank = 0; rank < positions->len; rank++ )
+    {
+      if ( g_array_index (positions, int, rank) == pkg->path_position )
+        break;
+    }
+
+  fingerprint_int (checksum, rank);
+
+  /* Set by the parser, see parse_digest */
+  fingerprint_string (checksum, pkg->info->digest);
+}
+
+char *
+fingerprint_get (Package *pkg_config, GList *packages)
+{
+  GChecksum *checksum;
+  GPtrArray *closure;
+  GArray *positions;
+  GList *order;
+  GList *iter;
+  Package *pkg;
+  char *result;
+  guint i;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  fingerprint_options (checksum, pkg_config);
+
+  closure = g_ptr_array_new ( );
+  positions = g_array_new (FALSE, FALSE, sizeof (int));
+
+  order = graph_order (packages, TRUE);
+  for ( iter = order; iter != NULL; iter = iter->next )
+    {
+      pkg = iter->data;
+
+      g_ptr_array_add (closure, pkg);
+      g_array_append_val (positions, pkg->path_position);
+    }
+
+  g_list_free (order);
+
+  g_ptr_array_sort (closure, fingerprint_compare_keys);
+  g_array_sort (positions, fingerprint_compare_ints);
+
+  fingerprint_string (checksum, "packages");
+  fingerprint_int (checksum, closure->len);
+
+  for ( i = 0; i < closure->len; i++ )
+    fingerprint_package (checksum, g_ptr_array_index (closure, i), positions);
+
+  result = g_strconcat (g_checksum_get_string (checksum), "\n", NULL);
+
+  g_array_free (positions, TRUE);
+  g_ptr_array_free (closure, TRUE);
+  g_checksum_free (checksum);
+
+  return result;
+}
+
+void
+fingerprint_begin (int argc, char **argv)
+{
+  int i;
+
+  for ( i = 1; i < argc; i++ )
+    {
+      if ( strcmp (argv[i], "--") == 0 )
+        break;
+
+      /* The files are hashed as they are parsed */
+      if ( strcmp (argv[i], "--fingerprint") == 0 )
+        {
+          parse_digest = TRUE;
+          break;
+        }
+    }
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _FINGERPRINT_H_
+#define _FINGERPRINT_H_
+
+#include <glib.h>
+
+#include "package.h"
+
+
+/* --fingerprint: the SHA-256 digest in hexadecimal of everything the
+ * flags of the given packages are derived from, newline included, for use
+ * in compiler cache keys */
+char *fingerprint_get (Package *pkg_config, GList *packages);
+
+/* Called with the command line before anything is parsed, so the digest
+ * of pkg-config.pc is taken as well */
+void fingerprint_begin (int argc, char **argv);
+
+
+#endif  /* _FINGERPRINT_H_ */
@@ -17,9 +17,13 @@
  * 02111-1307, USA.
  */
 
+#include <string.h>
+
 #include "flag.h"
 #include "globals.h"
 #include "package.h"
+#include "stats.h"
+#include "trace.h"
 #include "utils.h"
 
 
@@ -27,40 +31,148 @@
  * Code
  */
 
-void
-flag_free (Flag *flag)
+#if defined(__GNUC__)
+  #define flag_lowest_bit(w)  ((guint) __builtin_ctzll (w))
+#else
+static guint
+flag_lowest_bit (guint64 word)
 {
-  g_free (flag->arg);
-  g_free (flag);
+  guint bit = 0;
+
+  while ( !(word & 1) )
+    {
+      word >>= 1;
+      bit++;
+    }
+
+  return bit;
 }
+#endif
 
-Flag *
-flag_create (FlagType type, char *arg)
+/* Bitmap number of a single FlagType bit */
+static guint
+flag_type_index (guint8 type)
 {
-  Flag *flag;
+  guint t = 0;
 
-  flag = g_new0 (Flag, 1);
-  flag->type = type;
-  flag->arg = arg;
-  return flag;
+  while ( type > 1 )
+    {
+      type >>= 1;
+      t++;
+    }
+
+  return t;
 }
 
-#if !GLIB_CHECK_VERSION(2,28,0)
+/* Words in each bitmap of a set of the given size */
+static guint
+flag_set_words (guint size)
+{
+  return (size + 63) / 64;
+}
 
 static void
-flag_list_foreach_free (gpointer data, gpointer user_data)
+flag_set_index (FlagSet *set, guint from)
+{
+  guint words = flag_set_words (set->size);
+  guint64 *bitmap;
+  guint i;
+
+  for ( i = from; i < set->len; i++ )
+    {
+      bitmap = set->bitmaps + flag_type_index (set->types[i]) * words;
+      bitmap[i / 64] |= G_GUINT64_CONSTANT (1) << (i % 64);
+    }
+}
+
+void
+flag_set_add (FlagSet *set, FlagType type, char *arg)
+{
+  guint words;
+
+  if ( set->len == set->size )
+    {
+      /* Most fields hold a few flags */
+      words = flag_set_words (set->size);
+      set->size = set->size == 0 ? 4 : set->size * 2;
+      set->types = g_renew (guint8, set->types, set->size);
+      set->args = g_renew (char *, set->args, set->size);
+
+      /* The bitmaps are laid out by words, so index them anew when a
+       * word is added */
+      if ( flag_set_words (set->size) != words )
+        {
+          g_free (set->bitmaps);
+          set->bitmaps = g_new0 (guint64, FLAG_TYPES * flag_set_words (set->size));
+          flag_set_index (set, 0);
+        }
+    }
+
+  set->types[set->len] = type;
+  set->args[set->len] = arg;
+  set->len++;
+
+  stats_count (STATS_FLAGS_CREATED);
+
+  flag_set_index (set, set->len - 1);
+}
+
+void
+flag_set_remove (FlagSet *set, guint index)
 {
-  flag_free (data);
+  g_free (set->args[index]);
+
+  set->len--;
+  memmove (set->types + index, set->types + index + 1, (set->len - index) * sizeof (guint8));
+  memmove (set->args + index, set->args + index + 1, (set->len - index) * sizeof (char *));
+
+  memset (set->bitmaps, 0, FLAG_TYPES * flag_set_words (set->size) * sizeof (guint64));
+  flag_set_index (set, 0);
 }
 
 void
-flag_free_list (GList *list)
+flag_set_free (FlagSet *set)
 {
-  g_list_foreach (list, flag_list_foreach_free, NULL);
-  g_list_free (list);
+  guint i;
+
+  for ( i = 0; i < set->len; i++ )
+    g_free (set->args[i]);
+
+  g_free (set->types);
+  g_free (set->args);
+  g_free (set->bitmaps);
 }
 
-#endif // !GLIB_CHECK_VERSION
+/* Append the flags of the given type(s) to 'flags' (array of Flag items)
+ * in their original order */
+void
+flag_set_select (const FlagSet *set, FlagType type, GArray *flags)
+{
+  guint words = flag_set_words (set->size);
+  guint64 word;
+  guint t;
+  guint w;
+  guint i;
+  Flag flag;
+
+  for ( w = 0; w < words; w++ )
+    {
+      word = 0;
+      for ( t = 0; t < FLAG_TYPES; t++ )
+        if ( type & (1 << t) )
+          word |= set->bitmaps[t * words + w];
+
+      while ( word != 0 )
+        {
+          i = w * 64 + flag_lowest_bit (word);
+          word &= word - 1;
+
+          flag.type = set->types[i];
+          flag.arg = set->args[i];
+          g_array_append_val (flags, flag);
+        }
+    }
+}
 
 char *
 flags_packages_get (GList *pkgs, FlagType flags)
@@ -68,6 +180,8 @@ flags_packages_get (GList *pkgs, FlagType flags)
   GString *str;
   char *cur;
 
+  stats_enter (STATS_OUTPUT);
+
   str = g_string_new (NULL);
 
   /* sort packages in path order for -L/-I, dependency order otherwise */
@@ -110,54 +224,46 @@ flags_packages_get (GList *pkgs, FlagType flags)
     g_string_truncate (str, str->len - 1);
 
   debug_spew ("returning flags string \"%s\"\n", str->str);
+
+  stats_leave ( );
   return g_string_free (str, FALSE);
 }
 
 /* Merge the flags from the individual packages
- * List of flag pointers */
-GList *
+ * Array of Flag items */
+GArray *
 flag_merge_lists (GList *packages, FlagType type)
 {
-  TailList merged;
+  GArray *merged;
   Package *pkg;
-  GList *flags;
-  Flag *flag;
 
-  tail_list_init (merged);
+  merged = g_array_new (FALSE, FALSE, sizeof (Flag));
 
-  /* Keep track of the last element to avoid traversing the whole list */
   for ( ; packages != NULL; packages = packages->next )
     {
       pkg = packages->data;
 
-      /* Manually copy the elements so we can keep track of the end */
-      for ( flags = (type & LIBS_ANY) ? pkg->libs.items : pkg->cflags.items; flags != NULL; flags = flags->next )
-        {
-          flag = flags->data;
-
-          if ( flag->type & type )
-            tail_list_add (&merged, flag);
-        }
+      flag_set_select ((type & LIBS_ANY) ? &pkg->libs : &pkg->cflags, type, merged);
     }
 
-  return merged.items;
+  return merged;
 }
 
 char *
-flag_list_to_string (GList *list)
+flag_list_to_string (GArray *flags)
 {
-  GList *iter;
   GString *str;
   char *retval;
   Flag *flag;
   char *arg;
   char *space;
+  guint i;
 
   str = g_string_new ("");
 
-  for ( iter = list; iter != NULL; iter = iter->next )
+  for ( i = 0; i < flags->len; i++ )
     {
-      flag = iter->data;
+      flag = &g_array_index (flags, Flag, i);
       arg = flag->arg;
 
       if (pcsysrootdir != NULL && flag->type & (CFLAGS_I | LIBS_L))
@@ -199,44 +305,58 @@ flag_list_to_string (GList *list)
   return retval;
 }
 
-/* Strip consecutive duplicate arguments in the flag list. */
-GList *
-flag_list_strip_duplicates (GList *list)
+/* Strip consecutive duplicate arguments in the flag array. */
+void
+flag_list_strip_duplicates (GArray *flags)
 {
-  GList *iter;
-  Flag *curr_flag;
   Flag *prev_flag;
-  GList *temp;
+  Flag *curr_flag;
+  guint kept;
+  guint i;
 
-  if (list == NULL)
-    return NULL;
+  if (flags->len == 0)
+    return;
 
-  /* Start at the 2nd element of the list so we don't have to check for an
-   * existing previous element. */
-  for ( prev_flag = list->data, iter = list->next; iter != NULL; /* Nop! */ )
+  /* Start at the 2nd element so we don't have to check for an existing
+   * previous element; kept flags are moved down over the removed ones. */
+  for ( kept = 1, i = 1; i < flags->len; i++ )
     {
-      curr_flag = iter->data;
+      prev_flag = &g_array_index (flags, Flag, kept - 1);
+      curr_flag = &g_array_index (flags, Flag, i);
 
-      if (curr_flag->type != prev_flag->type || strcmp (curr_flag->arg, prev_flag->arg) != 0)
+      if (curr_flag->type == prev_flag->type && strcmp (curr_flag->arg, prev_flag->arg) == 0)
         {
-          prev_flag = curr_flag;
-          iter = iter->next;
+          debug_spew (" removing duplicate \"%s\"\n", curr_flag->arg);
           continue;
         }
 
-      debug_spew (" removing duplicate \"%s\"\n", curr_flag->arg);
+      g_array_index (flags, Flag, kept) = *curr_flag;
+      kept++;
+    }
 
-      /* Remove the duplicate flag object from the list and move to the next item */
-      temp = iter;
-      iter = iter->next;
-      list = g_list_delete_link (list, temp);
+  stats_count_n (STATS_FLAGS_DEDUPLICATED, flags->len - kept);
+  g_array_set_size (flags, kept);
+}
 
-#if !GLIB_CHECK_VERSION(2,28,0)
-      free_flag (curr_flag);
-#endif
+/* Name of a flag type in trace spans */
+static const char *
+flag_type_name (FlagType type)
+{
+  switch (type)
+    {
+    case CFLAGS_I:
+      return "cflags-only-I";
+    case CFLAGS_OTHER:
+      return "cflags-only-other";
+    case LIBS_L:
+      return "libs-only-L";
+    case LIBS_l:
+      return "libs-only-l";
+    case LIBS_OTHER:
+      return "libs-only-other";
+    default:
+      return "libs";
     }
-
-  return list;
 }
 
 /* Create a merged list of required packages and retrieve the flags from them.
@@ -250,13 +370,21 @@ char *
 flag_get_multi_merged (GList *pkgs, FlagType type, gboolean in_path_order,
                   gboolean include_private)
 {
-  GList *list;
+  GArray *flags;
   char *retval;
 
-  list = fill_list (pkgs, type, in_path_order, include_private);
-  list = flag_list_strip_duplicates (list);
-  retval = flag_list_to_string (list);
-  g_list_free (list);
+  trace_enter ("merge", flag_type_name (type));
+
+  flags = fill_list (pkgs, type, in_path_order, include_private);
+  trace_arg_int ("flags", flags->len);
+
+  flag_list_strip_duplicates (flags);
+  trace_arg_int ("unique_flags", flags->len);
+
+  retval = flag_list_to_string (flags);
+  g_array_free (flags, TRUE);
+
+  trace_leave ( );
 
   return retval;
 }
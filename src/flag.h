@@ -34,11 +34,8 @@ typedef enum {
     FLAGS_ANY    = (LIBS_ANY | CFLAGS_ANY)
 } FlagType;
 
-#if GLIB_CHECK_VERSION(2,28,0)
-  #define flag_free_list(l)   g_list_free_full ((l), (GDestroyNotify) flag_free)
-#else
-  void flag_free_list (GList *list);
-#endif // GLIB_CHECK_VERSION
+/* Number of single type bits in FlagType */
+#define FLAG_TYPES  5
 
 typedef struct
 {
@@ -46,13 +43,27 @@ typedef struct
   char *arg;
 } Flag;
 
+/* The flags of one package field, stored contiguously: a type array and a
+ * parallel argument array, plus one bitmap per single FlagType bit so the
+ * flags of a type are found by scanning bitmap words */
+typedef struct
+{
+  guint8 *types;
+  char **args;
+  guint64 *bitmaps;   /* FLAG_TYPES bitmaps of (size + 63) / 64 words each */
+  guint len;
+  guint size;         /* allocated entries */
+} FlagSet;
+
 
-void flag_free (Flag *flag);
-Flag * flag_create (FlagType type, char *arg);
+void flag_set_add (FlagSet *set, FlagType type, char *arg);
+void flag_set_remove (FlagSet *set, guint index);
+void flag_set_free (FlagSet *set);
+void flag_set_select (const FlagSet *set, FlagType type, GArray *flags);
 
-GList * flag_merge_lists (GList *packages, FlagType type);
-char * flag_list_to_string (GList *list);
-GList * flag_list_strip_duplicates (GList *list);
+GArray * flag_merge_lists (GList *packages, FlagType type);
+char * flag_list_to_string (GArray *flags);
+void flag_list_strip_duplicates (GArray *flags);
 
 char * flags_packages_get (GList *pkgs, FlagType flags);
 char * flag_get_multi_merged (GList *pkgs, FlagType type, gboolean in_path_order, gboolean include_private);
@@ -44,6 +44,8 @@ char *pkg_config_pc_path = NULL;
 gboolean allow_system_cflags = FALSE;
 gboolean allow_system_libs = FALSE;
 
+int prefetch_threads = 4;
+
 gboolean want_my_version = FALSE;
 gboolean want_version = FALSE;
 FlagType pkg_flags = 0;
@@ -52,11 +54,16 @@ gboolean want_static_lib_list = ENABLE_INDIRECT_DEPS;
 gboolean want_short_errors = FALSE;
 gboolean want_uninstalled = FALSE;
 char *variable_name = NULL;
+GList *requested_variables = NULL;
 gboolean want_exists = FALSE;
 gboolean want_provides = FALSE;
 gboolean want_requires = FALSE;
 gboolean want_requires_private = FALSE;
 gboolean want_validate = FALSE;
+gboolean want_validate_all = FALSE;
+gboolean want_json = FALSE;
+gboolean want_export = FALSE;
+gboolean want_fingerprint = FALSE;
 char *required_atleast_version = NULL;
 char *required_exact_version = NULL;
 char *required_max_version = NULL;
@@ -71,6 +78,9 @@ gboolean want_debug_spew = FALSE;
 
 gboolean want_verbose_errors = FALSE;
 gboolean want_stdout_errors = FALSE;
+gboolean want_stats = FALSE;
+gboolean stats_json = FALSE;
+gboolean want_trace = FALSE;
 gboolean output_opt_set = FALSE;
 
 /*
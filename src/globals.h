@@ -47,6 +47,9 @@ extern gboolean disable_uninstalled;
 extern gboolean allow_system_cflags;
 extern gboolean allow_system_libs;
 
+/* Size of the I/O thread pool loading required packages, 0 disables it */
+extern int prefetch_threads;
+
 /* pkg-config default search path. On Windows the current pkg-config install
  * directory is used. Otherwise, the build-time defined PKG_CONFIG_PC_PATH.
  */
@@ -55,6 +58,7 @@ extern char *pkg_config_pc_path;
 
 /* Exit on parse errors if TRUE. */
 extern gboolean parse_strict;
+extern gboolean parse_digest;
 
 /* If TRUE, define "prefix" in .pc files at runtime. */
 extern gboolean define_prefix;
@@ -75,11 +79,16 @@ extern gboolean want_static_lib_list;
 extern gboolean want_short_errors;
 extern gboolean want_uninstalled;
 extern char *variable_name;
+extern GList *requested_variables;
 extern gboolean want_exists;
 extern gboolean want_provides;
 extern gboolean want_requires;
 extern gboolean want_requires_private;
 extern gboolean want_validate;
+extern gboolean want_validate_all;
+extern gboolean want_json;
+extern gboolean want_export;
+extern gboolean want_fingerprint;
 extern char *required_atleast_version;
 extern char *required_exact_version;
 extern char *required_max_version;
@@ -94,6 +103,9 @@ extern gboolean want_debug_spew;
 
 extern gboolean want_verbose_errors;
 extern gboolean want_stdout_errors;
+extern gboolean want_stats;
+extern gboolean stats_json;
+extern gboolean want_trace;
 extern gboolean output_opt_set;
 
 
@@ -0,0 +1,439 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <string.h>
+
+#include "graph.h"
+#include "globals.h"
+#include "utils.h"
+
+
+typedef struct
+{
+  guint first;                  /* first edge in the edge array */
+  guint count;
+  gboolean claimed;             /* requirements are being or have been pulled in */
+} Span;
+
+typedef struct
+{
+  guint epoch;                  /* search that visited the package last */
+  guint index;                  /* depth first search number */
+  guint low;                    /* lowest index reachable, see Tarjan */
+  gboolean on_stack;            /* still part of an open component */
+} Node;
+
+typedef struct
+{
+  guint id;
+  guint first;                  /* edges of the package */
+  guint left;                   /* edges still to visit, walking backwards */
+} Frame;
+
+typedef struct
+{
+  Node *nodes;                  /* see 'marks' */
+  GArray *frames;               /* explicit depth first search stack */
+  GArray *open;                 /* Tarjan's stack of package numbers */
+  guint next_index;
+  gboolean include_private;
+  GList *order;                 /* result, built by prepending */
+} Search;
+
+
+/* Package pointers by number; removed packages leave a NULL behind */
+static GPtrArray *nodes = NULL;
+
+/* Span of the edge array for every package number */
+static GArray *spans = NULL;
+
+/* All edges, see GRAPH_EDGE */
+static GArray *edges = NULL;
+
+/* Search state for every package number. A slot belongs to the current
+ * search only when its epoch matches 'epoch', so a search starts without
+ * clearing or allocating anything */
+static GArray *marks = NULL;
+static guint epoch = 0;
+
+/* Stacks of the search, kept between searches */
+static GArray *frame_stack = NULL;
+static GArray *component_stack = NULL;
+
+/* The last order computed; flags of different types are usually collected
+ * from the same package list several times in a row */
+static GList *memo_roots = NULL;
+static gboolean memo_private = FALSE;
+static GList *memo_order = NULL;
+
+
+/*
+ * Code
+ */
+
+static void
+graph_init (void)
+{
+  Span none = { 0, 0, FALSE };
+
+  if ( nodes != NULL )
+    return;
+
+  nodes = g_ptr_array_new ( );
+  spans = g_array_new (FALSE, FALSE, sizeof (Span));
+  edges = g_array_new (FALSE, FALSE, sizeof (guint));
+  marks = g_array_new (FALSE, TRUE, sizeof (Node));
+  frame_stack = g_array_new (FALSE, FALSE, sizeof (Frame));
+  component_stack = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  /* Number 0 is never used */
+  g_ptr_array_add (nodes, NULL);
+  g_array_append_val (spans, none);
+}
+
+void
+graph_add_node (Package *pkg)
+{
+  Span none = { 0, 0, FALSE };
+
+  graph_init ( );
+
+  pkg->id = nodes->len;
+
+  g_ptr_array_add (nodes, pkg);
+  g_array_append_val (spans, none);
+}
+
+void
+graph_remove_node (Package *pkg)
+{
+  if ( pkg->id == 0 )
+    return;
+
+  /* Edges pointing here are skipped from now on */
+  g_ptr_array_index (nodes, pkg->id) = NULL;
+  pkg->id = 0;
+
+  graph_forget ( );
+}
+
+gboolean
+graph_claim (Package *pkg)
+{
+  Span *span;
+
+  if ( pkg->id == 0 )
+    return TRUE;
+
+  span = &g_array_index (spans, Span, pkg->id);
+  if ( span->claimed )
+    return FALSE;
+
+  span->claimed = TRUE;
+  return TRUE;
+}
+
+void
+graph_set_edges (Package *pkg, const guint *list, guint count)
+{
+  Span *span;
+
+  if ( pkg->id == 0 )
+    return;
+
+  span = &g_array_index (spans, Span, pkg->id);
+  span->first = edges->len;
+  span->count = count;
+
+  g_array_append_vals (edges, list, count);
+
+  graph_forget ( );
+}
+
+const guint *
+graph_edges (const Package *pkg, guint *count)
+{
+  Span *span;
+
+  if ( pkg->id == 0 )
+    {
+      *count = 0;
+      return NULL;
+    }
+
+  span = &g_array_index (spans, Span, pkg->id);
+
+  *count = span->count;
+  return &g_array_index (edges, guint, span->first);
+}
+
+Package *
+graph_node (guint id)
+{
+  return g_ptr_array_index (nodes, id);
+}
+
+gboolean
+graph_requires_public (const Package *pkg, guint id)
+{
+  const guint *list;
+  guint count;
+  guint i;
+
+  list = graph_edges (pkg, &count);
+
+  for ( i = 0; i < count; i++ )
+    if ( list[i] == GRAPH_EDGE (id, FALSE) )
+      return TRUE;
+
+  return FALSE;
+}
+
+static void
+graph_enter (Search *search, guint id)
+{
+  Frame frame;
+  Node *node;
+  Span *span;
+
+  search->next_index++;
+
+  node = &search->nodes[id];
+  node->epoch = epoch;
+  node->index = search->next_index;
+  node->low = search->next_index;
+  node->on_stack = TRUE;
+
+  g_array_append_val (search->open, id);
+
+  /* Walk the requirements from the end to maintain order since the
+   * resulting list is built by prepending. */
+  span = &g_array_index (spans, Span, id);
+
+  frame.id = id;
+  frame.first = span->first;
+  frame.left = span->count;
+
+  g_array_append_val (search->frames, frame);
+}
+
+/* Pop the strongly connected component rooted at 'id' off Tarjan's stack */
+static void
+graph_close_component (Search *search, guint id)
+{
+  guint first;
+  guint i;
+
+  first = search->open->len;
+  do
+    first--;
+  while ( g_array_index (search->open, guint, first) != id );
+
+  if ( search->open->len - first > 1 )
+    {
+      debug_spew ("Circular requires between:");
+
+      for ( i = first; i < search->open->len; i++ )
+        debug_spew (" '%s'", graph_node (g_array_index (search->open, guint, i))->key);
+
+      debug_spew ("\n");
+    }
+
+  for ( i = first; i < search->open->len; i++ )
+    search->nodes[g_array_index (search->open, guint, i)].on_stack = FALSE;
+
+  g_array_set_size (search->open, first);
+}
+
+/* Iterative depth first search from package number 'root' */
+static void
+graph_visit (Search *search, guint root)
+{
+  Frame *frame;
+  Node *node;
+  Node *parent;
+  guint edge;
+  guint id;
+
+  if ( search->nodes[root].epoch == epoch )
+    {
+      debug_spew ("Package %s already in requires chain, skipping\n", graph_node (root)->key);
+      return;
+    }
+
+  graph_enter (search, root);
+
+  while ( search->frames->len > 0 )
+    {
+      frame = &g_array_index (search->frames, Frame, search->frames->len - 1);
+
+      if ( frame->left > 0 )
+        {
+          frame->left--;
+          edge = g_array_index (edges, guint, frame->first + frame->left);
+
+          if ( GRAPH_EDGE_PRIVATE (edge) && !search->include_private )
+            continue;
+
+          id = GRAPH_EDGE_TARGET (edge);
+          if ( graph_node (id) == NULL )
+            continue;
+
+          node = &search->nodes[id];
+          if ( node->epoch != epoch )
+            {
+              /* 'frame' is invalid after this */
+              graph_enter (search, id);
+              continue;
+            }
+
+          /* If the package has already been visited, then it is already in
+           * the order or it's an ancestor on a requires loop */
+          debug_spew ("Package %s already in requires chain, skipping\n", graph_node (id)->key);
+
+          if ( node->on_stack && node->index < search->nodes[frame->id].low )
+            search->nodes[frame->id].low = node->index;
+
+          continue;
+        }
+
+      /* All requirements are done */
+      id = frame->id;
+      search->order = g_list_prepend (search->order, graph_node (id));
+
+      node = &search->nodes[id];
+      if ( node->low == node->index )
+        graph_close_component (search, id);
+
+      g_array_set_size (search->frames, search->frames->len - 1);
+
+      if ( search->frames->len > 0 )
+        {
+          frame = &g_array_index (search->frames, Frame, search->frames->len - 1);
+          parent = &search->nodes[frame->id];
+
+          if ( node->low < parent->low )
+            parent->low = node->low;
+        }
+    }
+}
+
+static gboolean
+graph_memo_matches (GList *roots, gboolean include_private)
+{
+  GList *a;
+  GList *b;
+
+  if ( memo_order == NULL || memo_private != include_private )
+    return FALSE;
+
+  for ( a = roots, b = memo_roots; a != NULL && b != NULL; a = a->next, b = b->next )
+    if ( a->data != b->data )
+      return FALSE;
+
+  return a == NULL && b == NULL;
+}
+
+GList *
+graph_order (GList *roots, gboolean include_private)
+{
+  Search search;
+  Package *pkg;
+  GList *iter;
+
+  if ( graph_memo_matches (roots, include_private) )
+    return g_list_copy (memo_order);
+
+  graph_init ( );
+
+  g_array_set_size (marks, nodes->len);
+
+  /* Start a new search; stamps of the old ones become stale */
+  epoch++;
+  if ( epoch == 0 )
+    {
+      memset (marks->data, 0, marks->len * sizeof (Node));
+      epoch = 1;
+    }
+
+  search.nodes = (Node *) (void *) marks->data;
+  search.frames = frame_stack;
+  search.open = component_stack;
+  search.next_index = 0;
+  search.include_private = include_private;
+  search.order = NULL;
+
+  /* Start from the end of the requested package list to maintain order since
+   * the list is built by prepending. */
+  for ( iter = g_list_last (roots); iter != NULL; iter = iter->prev )
+    {
+      pkg = iter->data;
+
+      /* Not part of the graph, such as the virtual pkg-config package */
+      if ( pkg->id == 0 )
+        {
+          search.order = g_list_prepend (search.order, pkg);
+          continue;
+        }
+
+      graph_visit (&search, pkg->id);
+    }
+
+  /* Both stacks are empty again */
+  graph_forget ( );
+
+  memo_roots = g_list_copy (roots);
+  memo_private = include_private;
+  memo_order = search.order;
+
+  return g_list_copy (memo_order);
+}
+
+void
+graph_forget (void)
+{
+  g_list_free (memo_roots);
+  g_list_free (memo_order);
+
+  memo_roots = NULL;
+  memo_order = NULL;
+}
+
+void
+graph_release (void)
+{
+  graph_forget ( );
+
+  if ( nodes == NULL )
+    return;
+
+  g_ptr_array_free (nodes, TRUE);
+  g_array_free (spans, TRUE);
+  g_array_free (edges, TRUE);
+  g_array_free (marks, TRUE);
+  g_array_free (frame_stack, TRUE);
+  g_array_free (component_stack, TRUE);
+
+  nodes = NULL;
+  spans = NULL;
+  edges = NULL;
+  marks = NULL;
+  frame_stack = NULL;
+  component_stack = NULL;
+}
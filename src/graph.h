@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _GRAPH_H_
+#define _GRAPH_H_
+
+#include <glib.h>
+#include "package.h"
+
+
+/* The resolved dependency graph in compressed sparse row form: packages are
+ * numbered densely from 1 (0 means not part of the graph) and the
+ * requirements of each package are one contiguous run in a shared edge
+ * array, Requires.private edges first, then Requires edges, each group in
+ * file order. An edge is the number of the required package shifted left by
+ * one, with the lowest bit set for Requires.private */
+
+#define GRAPH_EDGE(id, private)   (((id) << 1) | ((private) ? 1 : 0))
+#define GRAPH_EDGE_TARGET(edge)   ((edge) >> 1)
+#define GRAPH_EDGE_PRIVATE(edge)  ((edge) & 1)
+
+
+void graph_add_node (Package *pkg);
+void graph_remove_node (Package *pkg);
+
+/* TRUE the first time it's called for a package: the caller is the one
+ * that pulls in its requirements */
+gboolean graph_claim (Package *pkg);
+
+void graph_set_edges (Package *pkg, const guint *edges, guint count);
+const guint * graph_edges (const Package *pkg, guint *count);
+Package * graph_node (guint id);
+
+/* TRUE when 'pkg' has a Requires edge to package number 'id' */
+gboolean graph_requires_public (const Package *pkg, guint id);
+
+/* Topological order of the packages reachable from 'roots' (list of package
+ * pointers): every package is listed once and comes before any package it
+ * depends on. Packages within a dependency cycle keep the order in which
+ * the depth first search reached them. The returned list must be freed with
+ * g_list_free */
+GList * graph_order (GList *roots, gboolean include_private);
+
+/* Drop the remembered order */
+void graph_forget (void);
+
+void graph_release (void);
+
+
+#endif  /* _GRAPH_H_ */
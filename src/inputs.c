@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <sys/stat.h>
+
+#include "inputs.h"
+#include "globals.h"
+#include "stats.h"
+
+
+/* Nothing is recorded unless somebody asked for it */
+static gboolean enabled = FALSE;
+
+/* Inputs in the order they were consulted */
+static TailList inputs = { NULL, NULL };
+
+/* Hash table with Input items and path pointers (keys) */
+static GHashTable *seen = NULL;
+
+
+/*
+ * Code
+ */
+
+void
+inputs_enable (void)
+{
+  enabled = TRUE;
+}
+
+gboolean
+inputs_enabled (void)
+{
+  return enabled;
+}
+
+gboolean
+input_stat (Input *input, const char *path, gboolean is_dir)
+{
+  struct stat st;
+
+  input->is_dir = is_dir;
+
+  stats_count (STATS_STAT_CALLS);
+  if ( stat (path, &st) != 0 )
+    {
+      input->exists = FALSE;
+      input->mtime = 0;
+      input->size = 0;
+      return FALSE;
+    }
+
+  input->exists = TRUE;
+#ifdef G_OS_WIN32
+  input->mtime = (gint64) st.st_mtime * G_GINT64_CONSTANT (1000000000);
+#else
+  input->mtime = (gint64) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+  input->size = st.st_size;
+
+  return TRUE;
+}
+
+gboolean
+input_is_current (const Input *input)
+{
+  Input now;
+
+  input_stat (&now, input->path, input->is_dir);
+
+  if ( now.exists != input->exists )
+    return FALSE;
+
+  /* A missing input is current as long as it is still missing */
+  if ( !now.exists )
+    return TRUE;
+
+  return now.mtime == input->mtime && now.size == input->size;
+}
+
+static void
+inputs_note (const char *path, gboolean is_dir)
+{
+  Input *input;
+
+  if ( !enabled )
+    return;
+
+  if ( seen == NULL )
+    seen = g_hash_table_new (g_str_hash, g_str_equal);
+  else if ( g_hash_table_lookup (seen, path) != NULL )
+    return;
+
+  input = g_new0 (Input, 1);
+  input->path = g_strdup (path);
+
+  /* The stat is taken when the input is first consulted so a later change
+   * always invalidates what was derived from it */
+  input_stat (input, path, is_dir);
+
+  g_hash_table_insert (seen, input->path, input);
+  tail_list_add (&inputs, input);
+}
+
+void
+inputs_note_file (const char *path)
+{
+  inputs_note (path, FALSE);
+}
+
+void
+inputs_note_dir (const char *path)
+{
+  inputs_note (path, TRUE);
+}
+
+/* Record the result of a search path lookup. Every directory probed before
+ * the hit matters too: a new .pc file there would change the answer. A miss
+ * (null location) depends on all search directories. */
+void
+inputs_note_lookup (const char *location, unsigned int path_position)
+{
+  GList *iter;
+  unsigned int position = 0;
+
+  if ( !enabled )
+    return;
+
+  for ( iter = search_dirs.items; iter != NULL; iter = iter->next )
+    {
+      position++;
+      if ( location != NULL && position > path_position )
+        break;
+
+      inputs_note_dir (iter->data);
+    }
+
+  if ( location != NULL )
+    inputs_note_file (location);
+}
+
+/* List of Input items */
+GList *
+inputs_get (void)
+{
+  return inputs.items;
+}
+
+static void
+input_free (Input *input)
+{
+  g_free (input->path);
+  g_free (input);
+}
+
+void
+inputs_release (void)
+{
+  GList *iter;
+
+  for ( iter = inputs.items; iter != NULL; iter = iter->next )
+    input_free (iter->data);
+
+  g_list_free (inputs.items);
+  tail_list_init (inputs);
+
+  if ( seen != NULL )
+    {
+      g_hash_table_destroy (seen);
+      seen = NULL;
+    }
+}
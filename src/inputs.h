@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _INPUTS_H_
+#define _INPUTS_H_
+
+#include <glib.h>
+
+
+/* A file or directory consulted while answering the query */
+typedef struct
+{
+  char *path;
+  gboolean is_dir;
+  gboolean exists;
+  gint64 mtime;     /* modification time in nanoseconds */
+  gint64 size;
+} Input;
+
+
+void inputs_enable (void);
+gboolean inputs_enabled (void);
+
+void inputs_note_file (const char *path);
+void inputs_note_dir (const char *path);
+void inputs_note_lookup (const char *location, unsigned int path_position);
+
+GList * inputs_get (void);
+gboolean input_stat (Input *input, const char *path, gboolean is_dir);
+gboolean input_is_current (const Input *input);
+
+void inputs_release (void);
+
+
+#endif  /* _INPUTS_H_ */
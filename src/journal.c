@@ -0,0 +1,729 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifndef G_OS_WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+#include "journal.h"
+#include "cache.h"
+#include "capture.h"
+#include "strutil.h"
+#include "utils.h"
+
+
+/*
+ * A journal is a file of records, one JSON object per line:
+ *
+ *   {"time":<unix time, us>,"duration_us":<n>,"status":<exit status>,
+ *    "output_bytes":<n>,"output_sha256":"<hex>","cwd":"<dir>",
+ *    "argv":["--cflags","glib-2.0"],"env":{"PKG_CONFIG_PATH":"<value>",...}}
+ *
+ * The digest of the output tells a changed answer of the same size apart;
+ * records without one are compared by size only.
+ *
+ * The environment holds the variables that may change the answer (see
+ * cache_env_relevant). Each record is written with a single write on a
+ * descriptor opened with O_APPEND, so concurrent pkg-config processes of a
+ * parallel build never interleave their records.
+ */
+
+typedef struct
+{
+  char *cwd;
+  GPtrArray *argv;              /* without argv[0] */
+  GPtrArray *env;               /* "NAME=value" */
+  int status;
+  gint64 output_bytes;
+  char *output_sha256;          /* NULL when not recorded */
+} JournalRecord;
+
+extern char **environ;
+
+static char *journal_path = NULL;
+static char **journal_argv = NULL;
+static int journal_argc = 0;
+static gint64 journal_time;
+static gint64 journal_start;
+
+
+/*
+ * Code
+ */
+
+/* Start timing the query; also captures its output to measure it */
+void
+journal_begin (int argc, char **argv)
+{
+  int i;
+
+  journal_path = getenv ("PKG_CONFIG_JOURNAL");
+  if ( journal_path == NULL || *journal_path == '\0' )
+    {
+      journal_path = NULL;
+      return;
+    }
+
+  journal_time = g_get_real_time ( );
+  journal_start = g_get_monotonic_time ( );
+
+  /* The option parser rearranges argv */
+  journal_argc = argc;
+  journal_argv = g_new (char *, argc + 1);
+  for ( i = 0; i < argc; i++ )
+    journal_argv[i] = g_strdup (argv[i]);
+  journal_argv[argc] = NULL;
+
+  capture_start ( );
+}
+
+/* Append the record of the query and its output (NULL when empty) */
+void
+journal_end (int status, const char *output, gsize length)
+{
+  GString *record;
+  char **iter;
+  char *digest;
+  char *name;
+  char *cwd;
+  char *eq;
+  int fd;
+  int i;
+
+  if ( journal_path == NULL )
+    return;
+
+  record = g_string_new (NULL);
+
+  digest = g_compute_checksum_for_data (G_CHECKSUM_SHA256,
+                                        (const guchar *) (output != NULL ? output : ""),
+                                        output != NULL ? length : 0);
+
+  g_string_append_printf (record, "{\"time\":%" G_GINT64_FORMAT ",\"duration_us\":%" G_GINT64_FORMAT
+                          ",\"status\":%d,\"output_bytes\":%lu,\"output_sha256\":\"%s\",\"cwd\":",
+                          journal_time, g_get_monotonic_time ( ) - journal_start,
+                          status, (unsigned long) length, digest);
+  g_free (digest);
+
+  cwd = g_get_current_dir ( );
+  s_append_json (record, cwd);
+  g_free (cwd);
+
+  g_string_append (record, ",\"argv\":[");
+  for ( i = 1; i < journal_argc; i++ )
+    {
+      if ( i > 1 )
+        g_string_append_c (record, ',');
+      s_append_json (record, journal_argv[i]);
+    }
+
+  g_string_append (record, "],\"env\":{");
+  for ( iter = environ, i = 0; *iter != NULL; iter++ )
+    {
+      if ( !cache_env_relevant (*iter) || strncmp (*iter, "PKG_CONFIG_JOURNAL=", 19) == 0 )
+        continue;
+
+      eq = strchr (*iter, '=');
+      name = g_strndup (*iter, eq - *iter);
+
+      if ( i++ > 0 )
+        g_string_append_c (record, ',');
+      s_append_json (record, name);
+      g_string_append_c (record, ':');
+      s_append_json (record, eq + 1);
+
+      g_free (name);
+    }
+
+  g_string_append (record, "}}\n");
+
+  fd = open (journal_path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+  if ( fd < 0 || write (fd, record->str, record->len) != (gssize) record->len )
+    verbose_error ("Cannot write to journal '%s': %s\n", journal_path, g_strerror (errno));
+
+  if ( fd >= 0 )
+    close (fd);
+
+  g_string_free (record, TRUE);
+  g_strfreev (journal_argv);
+  journal_argv = NULL;
+  journal_path = NULL;
+}
+
+/*
+ * Reading records back; just enough JSON for the format above
+ */
+
+static void
+json_space (const char **p)
+{
+  while ( **p == ' ' || **p == '\t' || **p == '\r' || **p == '\n' )
+    (*p)++;
+}
+
+static gboolean
+json_expect (const char **p, char c)
+{
+  json_space (p);
+
+  if ( **p != c )
+    return FALSE;
+
+  (*p)++;
+  return TRUE;
+}
+
+/* Returns the unescaped string, NULL when malformed */
+static char *
+json_string (const char **p)
+{
+  GString *str;
+  const char *s;
+  gunichar u;
+  char *end;
+  char hex[5];
+
+  if ( !json_expect (p, '"') )
+    return NULL;
+
+  str = g_string_new (NULL);
+
+  for ( s = *p; *s != '"'; s++ )
+    {
+      if ( *s == '\0' )
+        goto fail;
+
+      if ( *s != '\\' )
+        {
+          g_string_append_c (str, *s);
+          continue;
+        }
+
+      switch ( *++s )
+        {
+        case 'n': g_string_append_c (str, '\n'); break;
+        case 't': g_string_append_c (str, '\t'); break;
+        case 'r': g_string_append_c (str, '\r'); break;
+        case 'b': g_string_append_c (str, '\b'); break;
+        case 'f': g_string_append_c (str, '\f'); break;
+        case '"': case '\\': case '/': g_string_append_c (str, *s); break;
+        case 'u':
+          memcpy (hex, s + 1, 4);
+          hex[4] = '\0';
+          u = (gunichar) strtoul (hex, &end, 16);
+          if ( end != hex + 4 )
+            goto fail;
+          g_string_append_unichar (str, u);
+          s += 4;
+          break;
+        default:
+          goto fail;
+        }
+    }
+
+  *p = s + 1;
+  return g_string_free (str, FALSE);
+
+fail:
+
+  g_string_free (str, TRUE);
+  return NULL;
+}
+
+static gboolean
+json_number (const char **p, gint64 *value)
+{
+  char *end;
+
+  json_space (p);
+
+  *value = g_ascii_strtoll (*p, &end, 10);
+  if ( end == *p )
+    return FALSE;
+
+  *p = end;
+  return TRUE;
+}
+
+/* Skip a value of a member that isn't used */
+static gboolean
+json_skip (const char **p)
+{
+  gint64 number;
+  char *str;
+  int depth = 0;
+
+  json_space (p);
+
+  if ( **p == '"' )
+    {
+      str = json_string (p);
+      g_free (str);
+      return str != NULL;
+    }
+
+  if ( **p != '[' && **p != '{' )
+    {
+      if ( strncmp (*p, "true", 4) == 0 || strncmp (*p, "null", 4) == 0 )
+        *p += 4;
+      else if ( strncmp (*p, "false", 5) == 0 )
+        *p += 5;
+      else
+        return json_number (p, &number);
+
+      return TRUE;
+    }
+
+  do
+    {
+      if ( **p == '"' )
+        {
+          str = json_string (p);
+          if ( str == NULL )
+            return FALSE;
+          g_free (str);
+          continue;
+        }
+
+      if ( **p == '[' || **p == '{' )
+        depth++;
+      else if ( **p == ']' || **p == '}' )
+        depth--;
+      else if ( **p == '\0' )
+        return FALSE;
+
+      (*p)++;
+    }
+  while ( depth > 0 );
+
+  return TRUE;
+}
+
+static void
+journal_record_free (JournalRecord *record)
+{
+  g_free (record->cwd);
+  g_free (record->output_sha256);
+  g_ptr_array_free (record->argv, TRUE);
+  g_ptr_array_free (record->env, TRUE);
+  g_free (record);
+}
+
+/* Returns NULL when the line isn't a record */
+static JournalRecord *
+journal_record_parse (const char *line)
+{
+  JournalRecord *record;
+  const char *p = line;
+  char *key;
+  char *value;
+  gint64 number;
+  gboolean ok = TRUE;
+
+  record = g_new0 (JournalRecord, 1);
+  record->argv = g_ptr_array_new_with_free_func (g_free);
+  record->env = g_ptr_array_new_with_free_func (g_free);
+  record->output_bytes = -1;
+
+  if ( !json_expect (&p, '{') )
+    goto fail;
+
+  json_space (&p);
+  if ( *p == '}' )
+    goto fail;
+
+  do
+    {
+      key = json_string (&p);
+      if ( key == NULL || !json_expect (&p, ':') )
+        {
+          g_free (key);
+          goto fail;
+        }
+
+      if ( strcmp (key, "argv") == 0 )
+        {
+          ok = json_expect (&p, '[');
+          json_space (&p);
+
+          if ( ok && *p != ']' )
+            do
+              {
+                value = json_string (&p);
+                ok = value != NULL;
+                if ( ok )
+                  g_ptr_array_add (record->argv, value);
+              }
+            while ( ok && json_expect (&p, ',') );
+
+          ok = ok && json_expect (&p, ']');
+        }
+      else if ( strcmp (key, "env") == 0 )
+        {
+          ok = json_expect (&p, '{');
+          json_space (&p);
+
+          if ( ok && *p != '}' )
+            do
+              {
+                value = json_string (&p);
+                ok = value != NULL && json_expect (&p, ':');
+                g_free (key);
+                key = value;
+
+                value = ok ? json_string (&p) : NULL;
+                ok = value != NULL;
+                if ( ok )
+                  g_ptr_array_add (record->env, g_strconcat (key, "=", value, NULL));
+                g_free (value);
+              }
+            while ( ok && json_expect (&p, ',') );
+
+          ok = ok && json_expect (&p, '}');
+        }
+      else if ( strcmp (key, "cwd") == 0 )
+        {
+          g_free (record->cwd);
+          record->cwd = json_string (&p);
+          ok = record->cwd != NULL;
+        }
+      else if ( strcmp (key, "status") == 0 )
+        {
+          ok = json_number (&p, &number);
+          record->status = (int) number;
+        }
+      else if ( strcmp (key, "output_bytes") == 0 )
+        ok = json_number (&p, &record->output_bytes);
+      else if ( strcmp (key, "output_sha256") == 0 )
+        {
+          g_free (record->output_sha256);
+          record->output_sha256 = json_string (&p);
+          ok = record->output_sha256 != NULL;
+        }
+      else
+        ok = json_skip (&p);
+
+      g_free (key);
+
+      if ( !ok )
+        goto fail;
+    }
+  while ( json_expect (&p, ',') );
+
+  if ( !json_expect (&p, '}') || record->cwd == NULL )
+    goto fail;
+
+  return record;
+
+fail:
+
+  journal_record_free (record);
+  return NULL;
+}
+
+/*
+ * Replay
+ */
+
+/* The journal given with --replay, found before anything else is set up */
+const char *
+journal_replay_requested (int argc, char **argv)
+{
+  int i;
+
+  for ( i = 1; i < argc; i++ )
+    {
+      if ( strcmp (argv[i], "--") == 0 )
+        break;
+
+      if ( strncmp (argv[i], "--replay=", 9) == 0 )
+        return argv[i] + 9;
+
+      if ( strcmp (argv[i], "--replay") == 0 && i + 1 < argc )
+        return argv[i + 1];
+    }
+
+  return NULL;
+}
+
+#ifndef G_OS_WIN32
+
+/* Set up the recorded environment and directory and run the query; only
+ * returns when the directory is gone */
+static void
+journal_replay_child (const JournalRecord *record, const char *argv0, JournalQuery query)
+{
+  GPtrArray *names;
+  char **iter;
+  char *eq;
+  char **argv;
+  guint i;
+
+  if ( chdir (record->cwd) != 0 )
+    return;
+
+  /* Drop the variables of this environment that matter, then put the
+   * recorded ones in */
+  names = g_ptr_array_new_with_free_func (g_free);
+  for ( iter = environ; *iter != NULL; iter++ )
+    {
+      if ( cache_env_relevant (*iter) )
+        g_ptr_array_add (names, g_strndup (*iter, strchr (*iter, '=') - *iter));
+    }
+
+  for ( i = 0; i < names->len; i++ )
+    g_unsetenv (g_ptr_array_index (names, i));
+
+  for ( i = 0; i < record->env->len; i++ )
+    {
+      eq = strchr (g_ptr_array_index (record->env, i), '=');
+      *eq = '\0';
+      g_setenv (g_ptr_array_index (record->env, i), eq + 1, TRUE);
+      *eq = '=';
+    }
+
+  /* Never record the replay itself */
+  g_unsetenv ("PKG_CONFIG_JOURNAL");
+
+  argv = g_new (char *, record->argv->len + 2);
+  argv[0] = (char *) argv0;
+  for ( i = 0; i < record->argv->len; i++ )
+    argv[i + 1] = g_ptr_array_index (record->argv, i);
+  argv[i + 1] = NULL;
+
+  exit (query (record->argv->len + 1, argv));
+}
+
+/* Run one record in a fork of this process, which is still in its initial
+ * state. Returns the exit status (-1 when it couldn't be run), the number
+ * of bytes the query printed and their SHA-256 */
+static int
+journal_replay_one (const JournalRecord *record, const char *argv0, JournalQuery query,
+                    gint64 *output_bytes, char **output_sha256)
+{
+  GChecksum *checksum;
+  char buf[4096];
+  gssize n;
+  pid_t pid;
+  int fds[2];
+  int devnull;
+  int status;
+
+  *output_bytes = 0;
+
+  if ( pipe (fds) != 0 )
+    return -1;
+
+  fflush (stdout);
+  fflush (stderr);
+
+  pid = fork ( );
+  if ( pid < 0 )
+    {
+      close (fds[0]);
+      close (fds[1]);
+      return -1;
+    }
+
+  if ( pid == 0 )
+    {
+      close (fds[0]);
+      dup2 (fds[1], STDOUT_FILENO);
+      close (fds[1]);
+
+      devnull = open ("/dev/null", O_WRONLY);
+      if ( devnull >= 0 )
+        {
+          dup2 (devnull, STDERR_FILENO);
+          close (devnull);
+        }
+
+      journal_replay_child (record, argv0, query);
+      _exit (127);
+    }
+
+  close (fds[1]);
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+  while ( (n = read (fds[0], buf, sizeof (buf))) != 0 )
+    {
+      if ( n < 0 && errno == EINTR )
+        continue;
+      if ( n < 0 )
+        break;
+
+      *output_bytes += n;
+      g_checksum_update (checksum, (const guchar *) buf, n);
+    }
+
+  close (fds[0]);
+
+  *output_sha256 = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+
+  while ( waitpid (pid, &status, 0) < 0 )
+    {
+      if ( errno != EINTR )
+        return -1;
+    }
+
+  if ( !WIFEXITED (status) || WEXITSTATUS (status) == 127 )
+    return -1;
+
+  return WEXITSTATUS (status);
+}
+
+static int
+journal_compare_gint64 (gconstpointer a, gconstpointer b)
+{
+  gint64 x = *(const gint64 *) a;
+  gint64 y = *(const gint64 *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+#define PERCENTILE_MS(a, p) \
+  (g_array_index ((a), gint64, MIN ((a)->len - 1, ((a)->len * (p) + 99) / 100 - 1)) / 1000.0)
+
+/* Run the queries of a journal one after another and report the
+ * throughput, and the queries whose answer changed since recorded */
+int
+journal_replay (const char *path, const char *argv0, JournalQuery query)
+{
+  JournalRecord *record;
+  GArray *latencies;
+  GError *error = NULL;
+  char *contents;
+  char **lines;
+  gint64 start;
+  gint64 elapsed;
+  gint64 begin;
+  gint64 latency;
+  gint64 output_bytes;
+  char *output_sha256 = NULL;
+  int status;
+  int skipped = 0;
+  int failed = 0;
+  int mismatches = 0;
+  int i;
+
+  if ( !g_file_get_contents (path, &contents, NULL, &error) )
+    {
+      spew ("Cannot read journal: %s\n", error->message);
+      g_clear_error (&error);
+      return 1;
+    }
+
+  lines = g_strsplit (contents, "\n", -1);
+  g_free (contents);
+
+  latencies = g_array_new (FALSE, FALSE, sizeof (gint64));
+  start = g_get_monotonic_time ( );
+
+  for ( i = 0; lines[i] != NULL; i++ )
+    {
+      if ( lines[i][0] == '\0' )
+        continue;
+
+      record = journal_record_parse (lines[i]);
+      if ( record == NULL )
+        {
+          skipped++;
+          continue;
+        }
+
+      begin = g_get_monotonic_time ( );
+      status = journal_replay_one (record, argv0, query, &output_bytes, &output_sha256);
+      latency = g_get_monotonic_time ( ) - begin;
+
+      if ( status < 0 )
+        {
+          failed++;
+          g_free (output_sha256);
+          output_sha256 = NULL;
+          journal_record_free (record);
+          continue;
+        }
+
+      g_array_append_val (latencies, latency);
+
+      if ( status != record->status ||
+           (record->output_bytes >= 0 && output_bytes != record->output_bytes) )
+        {
+          if ( mismatches++ < 10 )
+            spew ("Line %d: exit status %d with %" G_GINT64_FORMAT " bytes of output, "
+                  "recorded %d with %" G_GINT64_FORMAT "\n", i + 1, status, output_bytes,
+                  record->status, record->output_bytes);
+        }
+      else if ( record->output_sha256 != NULL &&
+                g_ascii_strcasecmp (output_sha256, record->output_sha256) != 0 )
+        {
+          if ( mismatches++ < 10 )
+            spew ("Line %d: exit status %d with %" G_GINT64_FORMAT " bytes of output as "
+                  "recorded, but different output\n", i + 1, status, output_bytes);
+        }
+
+      g_free (output_sha256);
+      output_sha256 = NULL;
+      journal_record_free (record);
+    }
+
+  elapsed = g_get_monotonic_time ( ) - start;
+  g_strfreev (lines);
+
+  printf ("replayed %u queries in %.3f s: %.1f queries/s\n", latencies->len,
+          elapsed / 1000000.0, elapsed > 0 ? latencies->len * 1000000.0 / elapsed : 0.0);
+
+  if ( latencies->len > 0 )
+    {
+      g_array_sort (latencies, journal_compare_gint64);
+
+      printf ("latency ms: p50 %.3f  p90 %.3f  p99 %.3f  max %.3f\n",
+              PERCENTILE_MS (latencies, 50), PERCENTILE_MS (latencies, 90),
+              PERCENTILE_MS (latencies, 99),
+              g_array_index (latencies, gint64, latencies->len - 1) / 1000.0);
+    }
+
+  printf ("changed answers: %d, not run: %d, malformed records: %d\n",
+          mismatches, failed, skipped);
+
+  g_array_free (latencies, TRUE);
+
+  return mismatches > 0 || failed > 0 || skipped > 0;
+}
+
+#else
+
+int
+journal_replay (const char *path, const char *argv0, JournalQuery query)
+{
+  spew ("--replay is not supported on this platform\n");
+  return 1;
+}
+
+#endif
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _JOURNAL_H_
+#define _JOURNAL_H_
+
+#include <glib.h>
+
+
+/* Query journal: with PKG_CONFIG_JOURNAL set, every query is appended to
+ * that file as one JSON line holding its arguments, working directory,
+ * relevant environment, start time, duration, exit status, output size
+ * and output digest. pkg-config --replay=JOURNAL runs a recorded query
+ * stream again and reports the throughput.
+ *
+ * This is not PKG_CONFIG_LOG: that one keeps its "name op version" lines
+ * for the scripts reading them, only covers the packages looked up and
+ * fails the query when it can't be opened, while the journal covers
+ * every query and never changes its outcome. */
+
+typedef int (*JournalQuery) (int argc, char **argv);
+
+void journal_begin (int argc, char **argv);
+void journal_end (int status, const char *output, gsize length);
+
+const char * journal_replay_requested (int argc, char **argv);
+int journal_replay (const char *path, const char *argv0, JournalQuery query);
+
+
+#endif  /* _JOURNAL_H_ */
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <string.h>
+
+#include "json.h"
+#include "flag.h"
+#include "globals.h"
+#include "graph.h"
+#include "parse.h"
+#include "reqver.h"
+#include "strutil.h"
+
+
+/*
+ * The document printed for 'pkg-config --json --variable=prefix foo':
+ *
+ *   {"packages":[{"name":"foo","version":"1.0",
+ *                 "requires":[{"name":"bar","comparison":">=","version":"2"}],
+ *                 "requires_private":[{"name":"baz"}],
+ *                 "variables":{"prefix":"/usr"}}],
+ *    "cflags":{"all":[...],"I":[...],"other":[...]},
+ *    "libs":{"all":[...],"L":[...],"l":[...],"other":[...]}}
+ *
+ * Flags are merged over all the packages exactly as the matching --cflags*
+ * and --libs* options do, and given as argument arrays: already split and
+ * unquoted, so nothing has to go through a shell. A variable a package
+ * doesn't define is null.
+ */
+
+
+/*
+ * Code
+ */
+
+/* Append a string of shell words as an array of the arguments */
+static void
+json_append_args (GString *json, const char *words)
+{
+  char **argv = NULL;
+  int argc = 0;
+  int i;
+
+  g_string_append_c (json, '[');
+
+  /* An empty string isn't a command line for g_shell_parse_argv */
+  if ( *words != '\0' && g_shell_parse_argv (words, &argc, &argv, NULL) )
+    {
+      for ( i = 0; i < argc; i++ )
+        {
+          if ( i > 0 )
+            g_string_append_c (json, ',');
+          s_append_json (json, argv[i]);
+        }
+
+      g_strfreev (argv);
+    }
+
+  g_string_append_c (json, ']');
+}
+
+static void
+json_append_flags (GString *json, const char *name, GList *packages, FlagType type)
+{
+  char *words;
+
+  s_append_json (json, name);
+  g_string_append_c (json, ':');
+
+  words = flags_packages_get (packages, type);
+  json_append_args (json, words);
+  g_free (words);
+}
+
+static void
+json_append_require (GString *json, Package *pkg, Package *req)
+{
+  RequiredVersion *ver = NULL;
+
+  if ( pkg->required_versions != NULL )
+    ver = g_hash_table_lookup (pkg->required_versions, req->key);
+
+  g_string_append (json, "{\"name\":");
+  s_append_json (json, req->key);
+
+  if ( ver != NULL && ver->comparison != ALWAYS_MATCH )
+    {
+      g_string_append (json, ",\"comparison\":");
+      s_append_json (json, comparison_to_str (ver->comparison));
+      g_string_append (json, ",\"version\":");
+      s_append_json (json, ver->version);
+    }
+
+  g_string_append_c (json, '}');
+}
+
+/* The same packages as --print-requires and --print-requires-private */
+static void
+json_append_requires (GString *json, Package *pkg, gboolean private)
+{
+  const guint *edges;
+  guint count;
+  guint i;
+  Package *req;
+  gboolean first = TRUE;
+
+  g_string_append_c (json, '[');
+
+  edges = graph_edges (pkg, &count);
+
+  for ( i = 0; i < count; i++ )
+    {
+      if ( GRAPH_EDGE_PRIVATE (edges[i]) != private )
+        continue;
+
+      if ( private && graph_requires_public (pkg, GRAPH_EDGE_TARGET (edges[i])) )
+        continue;
+
+      req = graph_node (GRAPH_EDGE_TARGET (edges[i]));
+      if ( req == NULL )
+        continue;
+
+      if ( !first )
+        g_string_append_c (json, ',');
+      first = FALSE;
+
+      json_append_require (json, pkg, req);
+    }
+
+  g_string_append_c (json, ']');
+}
+
+static void
+json_append_package (GString *json, Package *pkg_config, Package *pkg)
+{
+  GList *iter;
+  char *value;
+
+  g_string_append (json, "{\"name\":");
+  s_append_json (json, pkg->key);
+  g_string_append (json, ",\"version\":");
+  s_append_json (json, pkg->version);
+
+  g_string_append (json, ",\"requires\":");
+  json_append_requires (json, pkg, FALSE);
+  g_string_append (json, ",\"requires_private\":");
+  json_append_requires (json, pkg, TRUE);
+
+  g_string_append (json, ",\"variables\":{");
+  for ( iter = requested_variables; iter != NULL; iter = iter->next )
+    {
+      if ( iter != requested_variables )
+        g_string_append_c (json, ',');
+
+      s_append_json (json, iter->data);
+      g_string_append_c (json, ':');
+
+      value = parse_package_variable (pkg, pkg_config, iter->data);
+      if ( value != NULL )
+        s_append_json (json, value);
+      else
+        g_string_append (json, "null");
+
+      g_free (value);
+    }
+
+  g_string_append (json, "}}");
+}
+
+char *
+json_get (Package *pkg_config, GList *packages)
+{
+  GString *json;
+  GList *iter;
+
+  json = g_string_new ("{\"packages\":[");
+
+  for ( iter = packages; iter != NULL; iter = iter->next )
+    {
+      if ( iter != packages )
+        g_string_append_c (json, ',');
+
+      json_append_package (json, pkg_config, iter->data);
+    }
+
+  g_string_append (json, "],\"cflags\":{");
+  json_append_flags (json, "all", packages, CFLAGS_ANY);
+  g_string_append_c (json, ',');
+  json_append_flags (json, "I", packages, CFLAGS_I);
+  g_string_append_c (json, ',');
+  json_append_flags (json, "other", packages, CFLAGS_OTHER);
+
+  g_string_append (json, "},\"libs\":{");
+  json_append_flags (json, "all", packages, LIBS_ANY);
+  g_string_append_c (json, ',');
+  json_append_flags (json, "L", packages, LIBS_L);
+  g_string_append_c (json, ',');
+  json_append_flags (json, "l", packages, LIBS_l);
+  g_string_append_c (json, ',');
+  json_append_flags (json, "other", packages, LIBS_OTHER);
+  g_string_append (json, "}}\n");
+
+  return g_string_free (json, FALSE);
+}
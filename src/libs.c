@@ -49,28 +49,28 @@ lib_init_system_dirs (Package *pkg_config)
 void
 libs_verify (Package *pkg, Package *config)
 {
-  GList *iter;
+  guint i;
   char *libs;
-  Flag *flag;
+  char *arg;
 
-  for ( iter = pkg->libs.items; iter != NULL; )
+  for ( i = 0; i < pkg->libs.len; )
     {
-      flag = iter->data;
+      arg = pkg->libs.args[i];
 
-      if ( !(flag->type & LIBS_L) )
+      if ( !(pkg->libs.types[i] & LIBS_L) )
         {
           /* Move to the next item in the list */
-          iter = iter->next;
+          i++;
           continue;
         }
 
       /* Check '-L' first. */
-      libs = flag->arg;
+      libs = arg;
       if ( *libs++ != '-' ||  /* An empty string or doesn't begin w/ '-' character */
            *libs++ != 'L' )   /* "-" string or doesn't begin w/ "-L" */
         {
           /* Move to the next item in the list */
-          iter = iter->next;
+          i++;
           continue;
         }
 
@@ -78,24 +78,18 @@ libs_verify (Package *pkg, Package *config)
       if ( *libs == ' ' )
         libs++;
 
-      if ( !lib_is_system_dirs (libs, pkg->key, flag->arg ) )
+      if ( !lib_is_system_dirs (libs, pkg->key, arg ) )
         {
           /* Move to the next item in the list */
-          iter = iter->next;
+          i++;
           continue;
         }
 
-      debug_spew ("Removing %s from Libs for %s\n", flag->arg, pkg->key);
-
-      /* Remove the current item from the list including freeing the memory. Please note the
-       * pointer to the list is changed when it's the first item in the list. Then we move to
-       * the next item. */
-      tail_list_remove (&pkg->libs, iter);
+      debug_spew ("Removing %s from Libs for %s\n", arg, pkg->key);
 
-#if !GLIB_CHECK_VERSION(2,28,0)
-      /* Don't forget to destroy flag object */
-      free_flag (flag);
-#endif
+      /* Remove the current item including freeing the memory; the next item
+       * moves to the same index */
+      flag_set_remove (&pkg->libs, i);
     }
 }
 
@@ -153,7 +147,6 @@ libs_do_parse (Package *pkg, int argc, char **argv)
 #endif // G_OS_WIN32
 
   int i;
-  Flag *flag;
   FlagType type;
   char *tmp, *arg, *p;
   char *newarg;
@@ -164,9 +157,8 @@ libs_do_parse (Package *pkg, int argc, char **argv)
       if (tmp == NULL)
         return TRUE;
 
-      arg = s_dup_escape_shell (tmp);
+      arg = s_escape_shell (tmp);
       p = arg;
-      g_free (tmp);
 
       if ( p[0] == '-' &&
            p[1] == 'l' &&
@@ -204,8 +196,7 @@ libs_do_parse (Package *pkg, int argc, char **argv)
               return TRUE;
             }
 
-          p = s_dup_escape_shell (tmp);
-          g_free (tmp);
+          p = s_escape_shell (tmp);
 
           type = LIBS_OTHER;
           newarg = g_strconcat (arg, " ", p, NULL);
@@ -222,8 +213,7 @@ libs_do_parse (Package *pkg, int argc, char **argv)
           continue;
         }
 
-      flag = flag_create (type, newarg);
-      tail_list_add (&pkg->libs, flag);
+      flag_set_add (&pkg->libs, type, newarg);
     }
 
   return FALSE;
@@ -240,7 +230,7 @@ libs_parse (Package *pkg, Package *config, const char *str, const char *path)
   GError *error = NULL;
   gboolean die;
 
-  if (pkg->libs_num > 0)
+  if (pkg->info->libs_num > 0)
     {
       verbose_error ("Libs field occurs twice in '%s'\n", path);
       return parse_strict;
@@ -264,7 +254,7 @@ libs_parse (Package *pkg, Package *config, const char *str, const char *path)
 
   die = libs_do_parse (pkg, argc, argv);
   if ( !die )
-    pkg->libs_num++;
+    pkg->info->libs_num++;
 
 quit:
 
@@ -294,7 +284,7 @@ libs_parse_private (Package *pkg, Package *config, const char *str, const char *
   GError *error = NULL;
   gboolean die;
 
-  if (pkg->libs_private_num > 0)
+  if (pkg->info->libs_private_num > 0)
     {
       verbose_error ("Libs.private field occurs twice in '%s'\n", path);
       return parse_strict;
@@ -319,7 +309,7 @@ libs_parse_private (Package *pkg, Package *config, const char *str, const char *
 
   die = libs_do_parse (pkg, argc, argv);
   if ( !die )
-    pkg->libs_private_num++;
+    pkg->info->libs_private_num++;
 
 quit:
 
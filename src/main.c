@@ -20,14 +20,29 @@
 #include <locale.h>
 
 #include "main.h"
+#include "cache.h"
+#include "capture.h"
+#include "depfile.h"
+#include "export.h"
+#include "fingerprint.h"
 #include "globals.h"
+#include "graph.h"
+#include "journal.h"
+#include "json.h"
 #include "package.h"
 #include "parse.h"
+#include "probes.h"
 #include "strutil.h"
 #include "reqver.h"
+#include "stats.h"
+#include "trace.h"
 #include "utils.h"
+#include "validate.h"
 
 
+/* Only listed for --help: main looks for --replay before parsing anything */
+static char *replay_journal = NULL;
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpedantic"
 static const GOptionEntry options_table[] = {
@@ -96,6 +111,20 @@ static const GOptionEntry options_table[] = {
     "linking", NULL },
   { "validate", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK,
     &output_opt_cb, "validate a package's .pc file", NULL },
+  { "all", 0, 0, G_OPTION_ARG_NONE, &want_validate_all,
+    "with --validate, validate every .pc file of the search path (or of the "
+    "directories given) in parallel and print a sorted report", NULL },
+  { "json", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, &output_opt_cb,
+    "print the version, requirements, flags (as argument arrays) and the "
+    "variables given with --variable as one JSON document", NULL },
+  { "export", 0, 0, G_OPTION_ARG_CALLBACK, &output_opt_cb,
+    "print the flags and requirements of every package the given packages "
+    "depend on for inclusion in a build system; FORMAT is cmake, make or "
+    "ninja", "FORMAT" },
+  { "fingerprint", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK,
+    &output_opt_cb, "print a SHA-256 digest of the .pc files of every "
+    "package the given packages depend on and of the options and "
+    "environment the flags depend on", NULL },
   { "define-prefix", 0, 0, G_OPTION_ARG_NONE, &define_prefix,
     "try to override the value of prefix for each .pc file found with a "
     "guesstimated value based on the location of the .pc file", NULL },
@@ -106,6 +135,21 @@ static const GOptionEntry options_table[] = {
   { "prefix-variable", 0, 0, G_OPTION_ARG_STRING, &prefix_variable,
     "set the name of the variable that pkg-config automatically sets",
     "PREFIX" },
+  { "stats", 0, G_OPTION_FLAG_OPTIONAL_ARG, G_OPTION_ARG_CALLBACK, &stats_opt_cb,
+    "print the time spent in each phase and some counters to stderr at exit; "
+    "FORMAT is text (default) or json", "FORMAT" },
+  { "trace", 0, 0, G_OPTION_ARG_CALLBACK, &trace_opt_cb,
+    "write the package lookups, parsing, requirement resolution and flag "
+    "merging as Chrome trace events (JSON) to FILE", "FILE" },
+  { "depfile", 0, 0, G_OPTION_ARG_CALLBACK, &depfile_opt_cb,
+    "write the .pc files and search directories the answer depends on to "
+    "FILE as a Make/Ninja dependency file", "FILE" },
+  { "depfile-target", 0, 0, G_OPTION_ARG_CALLBACK, &depfile_opt_cb,
+    "name of the target in the dependency file (default: the file itself)",
+    "TARGET" },
+  { "replay", 0, 0, G_OPTION_ARG_FILENAME, &replay_journal,
+    "run the queries recorded in FILE through PKG_CONFIG_JOURNAL again and "
+    "report the throughput and the answers that changed", "FILE" },
 #ifdef G_OS_WIN32
   { "msvc-syntax", 0, 0, G_OPTION_ARG_NONE, &msvc_syntax,
     "output -l and -L flags for the Microsoft compiler (cl)", NULL },
@@ -150,11 +194,66 @@ quit:
   return success;
 }
 
+gboolean
+stats_opt_cb (const char *opt, const char *arg, gpointer data,
+              GError **error)
+{
+  if ( arg == NULL || strcmp (arg, "text") == 0 )
+    stats_json = FALSE;
+  else if ( strcmp (arg, "json") == 0 )
+    stats_json = TRUE;
+  else
+    {
+      spew ("Unknown --stats format '%s'\n", arg);
+
+      want_stats = FALSE;
+      return FALSE;
+    }
+
+  /* The report isn't part of the stored output */
+  stats_start ( );
+  cache_disable ( );
+
+  return TRUE;
+}
+
+gboolean
+trace_opt_cb (const char *opt, const char *arg, gpointer data,
+              GError **error)
+{
+  if ( !trace_start (arg) )
+    return FALSE;
+
+  /* A replayed answer would leave the trace empty */
+  cache_disable ( );
+
+  return TRUE;
+}
+
+gboolean
+depfile_opt_cb (const char *opt, const char *arg, gpointer data,
+                GError **error)
+{
+  if (strcmp (opt, "--depfile-target") == 0)
+    {
+      depfile_set_target (arg);
+      return TRUE;
+    }
+
+  depfile_start (arg);
+
+  /* A replayed answer wouldn't write the file */
+  cache_disable ( );
+
+  return TRUE;
+}
+
 gboolean
 output_opt_cb (const char *opt, const char *arg, gpointer data,
                GError **error)
 {
   static gboolean vercmp_opt_set = FALSE;
+  static gboolean only_variables = TRUE;
   gboolean bad_opt = TRUE;
 
   /* only allow one output mode, with a few exceptions */
@@ -176,6 +275,11 @@ output_opt_cb (const char *opt, const char *arg, gpointer data,
           (want_requires_private && strcmp (opt, "--print-requires") == 0))
         bad_opt = FALSE;
 
+      /* --json takes any number of --variable */
+      if ((want_json && strcmp (opt, "--variable") == 0) ||
+          (only_variables && strcmp (opt, "--json") == 0))
+        bad_opt = FALSE;
+
       /* --exists allowed with --atleast/exact/max-version */
       if (want_exists && !vercmp_opt_set &&
           (strcmp (opt, "--atleast-version") == 0 ||
@@ -209,7 +313,10 @@ output_opt_cb (const char *opt, const char *arg, gpointer data,
   else if (strcmp (opt, "--cflags-only-other") == 0)
     pkg_flags |= CFLAGS_OTHER;
   else if (strcmp (opt, "--variable") == 0)
-    variable_name = g_strdup (arg);
+    {
+      variable_name = g_strdup (arg);
+      requested_variables = g_list_append (requested_variables, g_strdup (arg));
+    }
   else if (strcmp (opt, "--exists") == 0)
     want_exists = TRUE;
   else if (strcmp (opt, "--print-variables") == 0)
@@ -244,9 +351,26 @@ output_opt_cb (const char *opt, const char *arg, gpointer data,
     want_requires_private = TRUE;
   else if (strcmp (opt, "--validate") == 0)
     want_validate = TRUE;
+  else if (strcmp (opt, "--json") == 0)
+    want_json = TRUE;
+  else if (strcmp (opt, "--export") == 0)
+    {
+      if (!export_set_format (arg))
+        {
+          spew ("Unknown --export format '%s'\n", arg);
+          return FALSE;
+        }
+
+      want_export = TRUE;
+    }
+  else if (strcmp (opt, "--fingerprint") == 0)
+    want_fingerprint = TRUE;
   else
     return FALSE;
 
+  if (strcmp (opt, "--variable") != 0)
+    only_variables = FALSE;
+
   output_opt_set = TRUE;
   return TRUE;
 }
@@ -259,7 +383,7 @@ print_list_data (gpointer data,
 }
 
 static Result
-process_package_args (Package *config, const char *cmdline, GList **packages, FILE *log)
+process_package_args (Package *config, int argc, char **argv, GList **packages, FILE *log)
 {
   GList *reqs;
   GList *curr;
@@ -271,7 +395,7 @@ process_package_args (Package *config, const char *cmdline, GList **packages, FI
 
   tail_list_init (new_packages);
 
-  reqs = parse_module_list (NULL, config, cmdline, "(command line arguments)", &temp);
+  reqs = parse_module_args (NULL, argc, argv, "(command line arguments)", &temp);
   if (reqs == NULL)
     {
       /*
@@ -296,24 +420,23 @@ process_package_args (Package *config, const char *cmdline, GList **packages, FI
       /* override requested versions with cmdline options */
       if (required_exact_version)
         {
-          g_free (ver->version);
           ver->comparison = EQUAL;
-          ver->version = g_strdup (required_exact_version);
+          ver->version = required_exact_version;
         }
       else if (required_atleast_version)
         {
-          g_free (ver->version);
           ver->comparison = GREATER_THAN_EQUAL;
-          ver->version = g_strdup (required_atleast_version);
+          ver->version = required_atleast_version;
         }
       else if (required_max_version)
         {
-          g_free (ver->version);
           ver->comparison = LESS_THAN_EQUAL;
-          ver->version = g_strdup (required_max_version);
+          ver->version = required_max_version;
         }
 
+      stats_enter (STATS_RESOLVE);
       req = package_get (config, ver->name, !want_short_errors, disable_uninstalled, &temp );
+      stats_leave ( );
       if (req == NULL)
         {
           if ( temp )
@@ -342,12 +465,12 @@ process_package_args (Package *config, const char *cmdline, GList **packages, FI
                          ver->name,
                          comparison_to_str (ver->comparison),
                          ver->version,
-                         req->name,
+                         req->info->name,
                          req->version);
 
-          if (req->url)
+          if (req->info->url)
             verbose_error ("You may find new versions of %s at %s\n",
-                           req->name, req->url);
+                           req->info->name, req->info->url);
 
           /* We don't need to destroy structure because it's added to hash table */
           continue;
@@ -376,15 +499,24 @@ quit:
 static void
 handle_package_requires_private ( Package *pkg )
 {
-  GList *iter;
+  const guint *edges;
+  guint count;
+  guint i;
   Package *deppkg;
   RequiredVersion *req;
 
-  for (iter = pkg->requires_private.items; iter != NULL; iter = iter->next)
+  edges = graph_edges (pkg, &count);
+
+  for (i = 0; i < count; i++)
     {
-      deppkg = iter->data;
+      if (!GRAPH_EDGE_PRIVATE (edges[i]))
+        continue;
+
+      if (graph_requires_public (pkg, GRAPH_EDGE_TARGET (edges[i])))
+        continue;
 
-      if (g_list_find (pkg->requires.items, deppkg))
+      deppkg = graph_node (GRAPH_EDGE_TARGET (edges[i]));
+      if (deppkg == NULL)
         continue;
 
       req = g_hash_table_lookup(pkg->required_versions, deppkg->key);
@@ -417,14 +549,23 @@ handle_requires_private ( GList *packages )
 static void
 handle_package_requires ( Package *pkg )
 {
-  GList *iter;
+  const guint *edges;
+  guint count;
+  guint i;
   Package *deppkg;
   RequiredVersion *req;
 
   /* process Requires: */
-  for (iter = pkg->requires.items; iter != NULL; iter = iter->next)
+  edges = graph_edges (pkg, &count);
+
+  for (i = 0; i < count; i++)
     {
-      deppkg = iter->data;
+      if (GRAPH_EDGE_PRIVATE (edges[i]))
+        continue;
+
+      deppkg = graph_node (GRAPH_EDGE_TARGET (edges[i]));
+      if (deppkg == NULL)
+        continue;
 
       req = g_hash_table_lookup(pkg->required_versions, deppkg->key);
       if ( req == NULL || req->comparison == ALWAYS_MATCH )
@@ -528,7 +669,7 @@ handle_variable_list ( GList *packages )
   for ( iter = packages; iter != NULL; iter = iter->next )
     {
       pkg = iter->data;
-      if (pkg->vars == NULL)
+      if (pkg->info->vars.len == 0)
         continue;
 
       /* Print newline after each package block except the last,
@@ -540,8 +681,7 @@ handle_variable_list ( GList *packages )
         printf ("\n");
 
       /* Sort variables for consistent output */
-      keys = g_hash_table_get_keys (pkg->vars);
-      keys = g_list_sort (keys, (GCompareFunc)g_strcmp0);
+      keys = var_map_sorted_names (&pkg->info->vars);
       g_list_foreach (keys, print_list_data, NULL);
       g_list_free (keys);
     }
@@ -606,6 +746,14 @@ handle_env_vars ( Package *pkg_config )
   else
       allow_system_libs = package_get_varval_bool (pkg_config, "allow_system_libs");
 
+  /* Prefetch threads */
+  var = getenv ("PKG_CONFIG_PREFETCH_THREADS");
+  if ( var == NULL )
+      var = package_get_var (pkg_config, "prefetch_threads");
+
+  if ( var != NULL )
+      prefetch_threads = atoi (var);
+
   return TRUE;
 }
 
@@ -614,7 +762,6 @@ handle_args ( Package *pkg_config, int argc, char **argv, GList **packages )
 {
   char *path;
   FILE *log = NULL;
-  GString *str;
   Result result;
 
   path = getenv("PKG_CONFIG_LOG");
@@ -636,23 +783,8 @@ handle_args ( Package *pkg_config, int argc, char **argv, GList **packages )
         }
     }
 
-  /* Collect packages from remaining args */
-  str = g_string_new ("");
-  while (argc > 1)
-    {
-      argc--;
-      argv++;
-
-      g_string_append (str, *argv);
-      g_string_append (str, " ");
-    }
-
-  g_strstrip (str->str);
-
-  /* find and parse each of the packages specified */
-  result = process_package_args (pkg_config, str->str, packages, log );
-
-  g_string_free (str, TRUE);
+  /* find and parse each of the packages specified in the remaining args */
+  result = process_package_args (pkg_config, argc - 1, argv + 1, packages, log );
 
   if ( log != NULL )
     fclose (log);
@@ -727,6 +859,7 @@ handle_options ( int *argc, char ***argv )
   /* honor Requires.private if any Cflags are requested or any static
    * libs are requested */
   if (pkg_flags & CFLAGS_ANY || want_requires_private || want_exists ||
+      want_json || want_export || want_fingerprint ||
       (want_static_lib_list && (pkg_flags & LIBS_ANY)))
     {
       enable_requires_private();
@@ -734,7 +867,8 @@ handle_options ( int *argc, char ***argv )
 
   /* ignore Requires if no Cflags or Libs are requested */
 
-  if (pkg_flags == 0 && !want_requires && !want_exists)
+  if (pkg_flags == 0 && !want_requires && !want_exists && !want_json &&
+      !want_export && !want_fingerprint)
     disable_requires();
 
   /* Allow errors in .pc files when listing all. */
@@ -758,6 +892,8 @@ handle ( Package *pkg_config, int argc, char **argv )
   if ( opt_context == NULL )
     return 1;
 
+  stats_leave ( );
+
   if (want_my_version)
     {
       printf ("%s\n", VERSION);
@@ -772,12 +908,28 @@ handle ( Package *pkg_config, int argc, char **argv )
       goto error;
     }
 
+  if (want_validate_all)
+    {
+      if (!want_validate)
+        {
+          spew ("--all can only be used with --validate\n");
+          goto error;
+        }
+
+      if ( !validate_all ( pkg_config, argc, argv ) )
+        goto error;
+
+      goto quit;
+    }
+
   if (want_list)
     {
       if ( !scan_dirs ( pkg_config ) )
         goto error;
 
+      stats_enter (STATS_OUTPUT);
       package_print_list ( pkg_config );
+      stats_leave ( );
       goto quit;
     }
 
@@ -790,6 +942,40 @@ handle ( Package *pkg_config, int argc, char **argv )
   if (want_exists || want_validate)
     goto quit;
 
+  /* Everything at once, from the same resolved packages */
+  if (want_json)
+    {
+      stats_enter (STATS_OUTPUT);
+      str = json_get (pkg_config, packages);
+      probe2 (output, "json", strlen (str));
+      printf ("%s", str);
+      g_free (str);
+      goto quit;
+    }
+
+  if (want_export)
+    {
+      stats_enter (STATS_OUTPUT);
+      str = export_get (pkg_config, packages);
+      probe2 (output, "export", strlen (str));
+      printf ("%s", str);
+      g_free (str);
+      goto quit;
+    }
+
+  if (want_fingerprint)
+    {
+      stats_enter (STATS_OUTPUT);
+      str = fingerprint_get (pkg_config, packages);
+      probe2 (output, "fingerprint", strlen (str));
+      printf ("%s", str);
+      g_free (str);
+      goto quit;
+    }
+
+  /* Everything from here on is output; the phase lasts until exit */
+  stats_enter (STATS_OUTPUT);
+
   if ( handle_variable_list ( packages ) )
     need_newline = FALSE;
 
@@ -807,6 +993,7 @@ handle ( Package *pkg_config, int argc, char **argv )
   if (variable_name)
     {
       str = packages_get_var (pkg_config, packages, variable_name);
+      probe2 (output, "variable", strlen (str));
       printf ("%s", str);
       g_free (str);
       need_newline = TRUE;
@@ -815,6 +1002,7 @@ handle ( Package *pkg_config, int argc, char **argv )
   if (pkg_flags != 0)
     {
       str = flags_packages_get (packages, pkg_flags);
+      probe2 (output, "flags", strlen (str));
       printf ("%s", str);
       g_free (str);
       need_newline = TRUE;
@@ -838,17 +1026,37 @@ error:
   return 1;
 }
 
-int
-main (int argc, char **argv)
+/* One query: everything but --replay, which runs many of these */
+static int
+query (int argc, char **argv)
 {
   Package *pkg_config;
+  char *output;
+  gsize length;
   int result = 0;
 
+  stats_begin (argc, argv);
+  journal_begin (argc, argv);
+  depfile_begin (argc, argv);
+  fingerprint_begin (argc, argv);
+
   setlocale (LC_CTYPE, "");
 #ifdef LC_MESSAGES
   setlocale (LC_MESSAGES, "");
 #endif
 
+  /* Replay the stored answer when the same query was already asked and
+   * nothing it consulted has changed since */
+  if ( cache_lookup (argc, argv, &result) )
+    {
+      output = capture_finish (&length);
+      journal_end (result, output, length);
+      g_free (output);
+      return result;
+    }
+
+  cache_begin ( );
+
   /* This is here so that we get debug spew from the start,
    * during arg parsing. Please note the following code has to be included
    * at the beginning of application */
@@ -859,7 +1067,9 @@ main (int argc, char **argv)
     }
 
   /* Initialize package variables and try to load package file */
+  stats_enter (STATS_CONFIG);
   pkg_config = packages_initialize ( );
+  stats_leave ( );
   if ( pkg_config != NULL )
     {
       /* Handle environment variables */
@@ -867,8 +1077,28 @@ main (int argc, char **argv)
         result = handle( pkg_config, argc, argv );
     }
 
+  /* Print captured output and store it for the next identical query */
+  output = capture_finish (&length);
+  cache_end (result, output, length);
+  journal_end (result, output, length);
+  g_free (output);
+
+  depfile_finish ( );
+  stats_report ( );
+  trace_finish ( );
   release( );
 
   return result;
 }
 
+int
+main (int argc, char **argv)
+{
+  const char *journal;
+
+  journal = journal_replay_requested (argc, argv);
+  if ( journal != NULL )
+    return journal_replay (journal, argv[0], query);
+
+  return query (argc, argv);
+}
@@ -29,5 +29,14 @@ output_opt_cb (const char *opt, const char *arg, gpointer data, GError **error);
 gboolean
 define_variable_cb (const char *opt, const char *arg, gpointer data, GError **error);
 
+gboolean
+stats_opt_cb (const char *opt, const char *arg, gpointer data, GError **error);
+
+gboolean
+trace_opt_cb (const char *opt, const char *arg, gpointer data, GError **error);
+
+gboolean
+depfile_opt_cb (const char *opt, const char *arg, gpointer data, GError **error);
+
 
 #endif  /* _MAIN_H_ */
@@ -19,13 +19,34 @@
 #include "package.h"
 #include "cflags.h"
 #include "globals.h"
+#include "graph.h"
+#include "inputs.h"
 #include "libs.h"
 #include "parse.h"
+#include "prefetch.h"
+#include "probes.h"
 #include "reqver.h"
+#include "stats.h"
 #include "strutil.h"
+#include "trace.h"
 #include "utils.h"
 
 
+typedef struct
+{
+  Package *pkg;
+  GList *entry;                 /* next RequiredVersion item to pull in */
+  gboolean private;             /* pulling in Requires.private */
+  guint pending;                /* first edge of the package in 'pending' */
+} PullFrame;
+
+typedef struct
+{
+  GArray *stack;                /* PullFrame items */
+  GArray *pending;              /* edges of the packages on the stack */
+} Pull;
+
+
 /*
  * Code
  */
@@ -43,34 +64,48 @@ package_free_list (GList *list)
   g_list_free (list);
 }
 
+/* New empty package; takes ownership of 'key' */
+Package *
+package_new (char *key)
+{
+  Package *pkg;
+
+  pkg = g_new0 (Package, 1);
+  pkg->key = key;
+  pkg->info = g_new0 (PackageInfo, 1);
+
+  return pkg;
+}
+
 void
 package_free (Package *pkg)
 {
-  g_free (pkg->orig_prefix);
+  PackageInfo *info = pkg->info;
+
   g_free (pkg->key);
-  g_free (pkg->name);
   g_free (pkg->version);
-  g_free (pkg->description);
-  g_free (pkg->url);
-  g_free (pkg->pcfiledir);
 
   required_version_free_list (pkg->requires_entries);
   required_version_free_list (pkg->requires_private_entries);
-  required_version_free_list (pkg->conflicts);
-
-  flag_free_list (pkg->libs.items);
-  flag_free_list (pkg->cflags.items);
 
-  g_list_free (pkg->requires.items);
-  g_list_free (pkg->requires_private.items);
-
-  /* This hash table has minimum one entry so no need to check */
-  if ( pkg->vars != NULL )
-    free_hash_table (pkg->vars);
+  flag_set_free (&pkg->libs);
+  flag_set_free (&pkg->cflags);
 
   if ( pkg->required_versions != NULL )
     g_hash_table_destroy (pkg->required_versions);
 
+  g_free (info->orig_prefix);
+  g_free (info->name);
+  g_free (info->description);
+  g_free (info->url);
+  g_free (info->pcfiledir);
+  g_free (info->digest);
+
+  required_version_free_list (info->conflicts);
+
+  var_map_free (&info->vars);
+
+  g_free (info);
   g_free (pkg);
 }
 
@@ -118,7 +153,7 @@ package_print_list (Package *config)
         pad = g_strnfill (mlen + 1 - strlen (pkg->key), ' ');
 
         printf ("%s%s%s - %s\n",
-                pkg->key, pad, pkg->name, pkg->description);
+                pkg->key, pad, pkg->info->name, pkg->info->description);
 
         g_free (pad);
     }
@@ -194,10 +229,10 @@ package_get_var_globals (Package *pkg,
       /* pkg-config package variable
        * Please note the package is created after reading pc file
        */
-      if ( config != NULL && config->vars != NULL )
+      if ( config != NULL )
         {
           temp_var = var_to_pkg_config_var (pkg->key, var);
-          temp_var_content = g_hash_table_lookup (config->vars, temp_var);
+          temp_var_content = var_map_get (&config->info->vars, temp_var);
           g_free (temp_var);
 
           if (temp_var_content != NULL)
@@ -208,13 +243,8 @@ package_get_var_globals (Package *pkg,
         }
     }
 
-  if (pkg->vars != NULL)
-  {
-    varval = g_hash_table_lookup (pkg->vars, var);
-    return g_strdup (varval);
-  }
-
-  return NULL;
+  varval = var_map_get (&pkg->info->vars, var);
+  return g_strdup (varval);
 }
 
 gboolean
@@ -244,7 +274,7 @@ package_verify_required_fields (Package *pkg)
       return FALSE;
     }
 
-  if (pkg->name == NULL)
+  if (pkg->info->name == NULL)
     {
       verbose_error ("Package '%s' has no Name: field\n",
                      pkg->key);
@@ -258,7 +288,7 @@ package_verify_required_fields (Package *pkg)
       return FALSE;
     }
 
-  if (pkg->description == NULL)
+  if (pkg->info->description == NULL)
     {
       verbose_error ("Package '%s' has no Description: field\n",
                      pkg->key);
@@ -299,16 +329,19 @@ package_verify (Package *pkg, Package *config)
 gboolean
 package_verify_required (Package *pkg)
 {
-  GList *requires = NULL;   /* List of package pointers */
-  GHashTable *visited;      /* Hash table of ??? pointers */
+  GList *requires;          /* List of package pointers */
   GList *iter;
 
+  /* Nothing can conflict */
+  if ( pkg->info->conflicts == NULL )
+    return TRUE;
+
   /* Make sure we didn't drag in any conflicts via Requires
    * (inefficient algorithm, who cares)
    */
-  visited = g_hash_table_new (g_str_hash, g_str_equal);
-  recursive_fill_list (pkg, TRUE, visited, &requires);
-  g_hash_table_destroy (visited);
+  iter = g_list_prepend (NULL, pkg);
+  requires = graph_order (iter, TRUE);
+  g_list_free (iter);
 
   for ( iter = requires; iter != NULL; iter = iter->next )
     {
@@ -327,7 +360,9 @@ package_verify_required (Package *pkg)
 gboolean
 package_verify_requires_private (Package *pkg)
 {
-  GList *iter;
+  const guint *edges;
+  guint count;
+  guint i;
   Package *req;
   RequiredVersion *ver;
 
@@ -336,9 +371,13 @@ package_verify_requires_private (Package *pkg)
     return TRUE;
 
   /* Make sure we have the right version for all requirements */
-  for ( iter = pkg->requires_private.items; iter != NULL; iter = iter->next )
+  edges = graph_edges (pkg, &count);
+
+  for ( i = 0; i < count; i++ )
     {
-      req = iter->data;
+      req = graph_node (GRAPH_EDGE_TARGET (edges[i]));
+      if ( req == NULL )
+        continue;
 
       ver = g_hash_table_lookup (pkg->required_versions, req->key);
       if ( ver == NULL )
@@ -354,9 +393,9 @@ package_verify_requires_private (Package *pkg)
                      req->key,
                      req->version);
 
-      if (req->url)
+      if (req->info->url)
         verbose_error ("You may find new versions of %s at %s\n",
-                       req->name, req->url);
+                       req->info->name, req->info->url);
 
       return FALSE;
     }
@@ -370,7 +409,7 @@ package_verify_required_item (Package *pkg, Package *req)
   GList *iter;
   RequiredVersion *ver;
 
-  for ( iter = pkg->conflicts; iter != NULL; iter = iter->next )
+  for ( iter = pkg->info->conflicts; iter != NULL; iter = iter->next )
     {
       ver = iter->data;
 
@@ -399,10 +438,7 @@ package_get_var (Package *pkg,
 {
   char *varval;
 
-  if ( pkg->vars == NULL )
-    return NULL;
-
-  varval = g_hash_table_lookup (pkg->vars, var);
+  varval = var_map_get (&pkg->info->vars, var);
   if ( varval == NULL )
     return NULL;
 
@@ -419,6 +455,9 @@ package_spew_list (const char *name,
   GList *iter;
   Package *pkg;
 
+  if (!want_debug_spew)
+    return;
+
   debug_spew ("  package>%s:", name);
 
   for ( iter = list; iter != NULL; iter = iter->next )
@@ -441,6 +480,7 @@ package_get_pkgconfig (gboolean *die)
   char *def_path;
 
   def_path = file_build_path (PKG_CONFIG_PACKAGE_PATH, def_name);
+  inputs_note_file (def_path);
 
   debug_spew ("Reading pkg-config package: '%s'\n", def_path);
   pkg_config = parse_package_file (def_name, def_path, NULL, TRUE, TRUE, TRUE, die);
@@ -508,6 +548,8 @@ package_create (Package *pkg_config, const char *name, gboolean warn, gboolean i
   unsigned int path_position;
   char *un;
 
+  probe1 (package__create__start, name);
+
   debug_spew ("Looking for package '%s'\n", name);
 
   /* treat "name" as a filename if it ends in .pc and exists */
@@ -522,6 +564,7 @@ package_create (Package *pkg_config, const char *name, gboolean warn, gboolean i
       key[strlen (key) - EXT_LEN] = '\0';
 
       path_position = 0;
+      inputs_note_file (location);
     }
   else
     {
@@ -538,6 +581,8 @@ package_create (Package *pkg_config, const char *name, gboolean warn, gboolean i
           if (pkg != NULL)
             {
               debug_spew ("Preferring uninstalled version of package '%s'\n", name);
+
+              probe3 (package__create__done, name, NULL, 1);
               return pkg;
             }
 
@@ -546,12 +591,21 @@ package_create (Package *pkg_config, const char *name, gboolean warn, gboolean i
            */
           if ( *die )
             {
+              probe3 (package__create__done, name, NULL, 0);
+
               /* We don't need to free anything in the function */
               return NULL;
             }
         }
 
-      location = file_find_in_search_dirs( name, &path_position );
+      stats_enter (STATS_LOOKUP);
+      trace_enter ("lookup", "lookup");
+      location = prefetch_find (name, &path_position);
+      trace_leave ( );
+      stats_leave ( );
+
+      inputs_note_lookup (location, path_position);
+
       if ( location == NULL )
         {
           if ( warn )
@@ -560,6 +614,8 @@ package_create (Package *pkg_config, const char *name, gboolean warn, gboolean i
                            "to the PKG_CONFIG_PATH environment variable\n",
                            name, name);
 
+          probe3 (package__create__done, name, NULL, 0);
+
           /* We don't need to free anything in the function */
           *die = FALSE;
           return NULL;
@@ -570,8 +626,10 @@ package_create (Package *pkg_config, const char *name, gboolean warn, gboolean i
 
   debug_spew ("Reading '%s' from file '%s'\n", name, location);
 
+  trace_enter ("parse", "parse");
   pkg = parse_package_file (key, location, pkg_config, ignore_requires,
                             ignore_private_libs, ignore_requires_private, die);
+  trace_leave ( );
 
   g_free (key);
 
@@ -579,6 +637,7 @@ package_create (Package *pkg_config, const char *name, gboolean warn, gboolean i
     {
       debug_spew ("Failed to parse '%s'\n", location);
 
+      probe3 (package__create__done, name, location, 0);
       g_free (location);
 
       *die = FALSE;
@@ -588,124 +647,273 @@ package_create (Package *pkg_config, const char *name, gboolean warn, gboolean i
   if (strstr (location, "uninstalled.pc"))
     pkg->uninstalled = TRUE;
 
-  g_free (location);
-
   pkg->path_position = path_position;
 
   debug_spew ("Path position of '%s' is %d\n", pkg->key, pkg->path_position);
 
+  /* The span of the package is the innermost one here */
+  trace_arg ("key", pkg->key);
+  trace_arg ("path", location);
+  trace_arg_int ("path_position", pkg->path_position);
+
+  probe3 (package__create__done, name, location, 1);
+  g_free (location);
+
   /* We have to add the package before pulling package requests! */
   packages_add (pkg);
+  stats_count (STATS_PACKAGES_LOADED);
 
   return pkg;
 }
 
-Package *
-package_get (Package *pkg_config, const char *name, gboolean warn, gboolean ignore_uninstalled, gboolean *die)
+/* Drop a package that couldn't be completed */
+static void
+package_discard (Package *pkg)
 {
-  Package *pkg;
+  graph_remove_node (pkg);
 
-  /* Package hash table has been created by the initialize funtion */
-  pkg = g_hash_table_lookup (packages, name);
-  if (pkg != NULL)
-    return pkg;
+  g_hash_table_remove (packages, pkg->key);
 
-  pkg = package_create (pkg_config, name, warn, ignore_uninstalled, die );
-  if ( pkg == NULL )
-    return NULL;
+#if !GLIB_CHECK_VERSION(2,28,0)
+  package_free (pkg);
+#endif
+}
 
-  /* pull in Requires packages */
-  if ( !package_pull_request (pkg, pkg_config, warn, ignore_uninstalled, die) )
-    goto quit;
+/* Start pulling in the requirements of a freshly created package */
+static void
+package_push (Pull *pull, Package *pkg, gboolean ignore_uninstalled)
+{
+  PullFrame frame;
 
-  /* pull in Requires.private packages */
-  if ( !package_pull_request_private (pkg, pkg_config, warn, ignore_uninstalled, die) )
-    goto quit;
+  /* Start loading the required packages in the background; they are still
+   * pulled in one by one in the order below */
+  prefetch_requires (pkg, ignore_uninstalled);
 
-  /* make requires_private include a copy of the public requires too */
-  tail_list_concat( &pkg->requires_private, pkg->requires.items );
+  trace_enter ("requires", "requires");
 
-  if ( !package_verify (pkg, pkg_config) )
-  {
-    *die = FALSE;
-    goto quit;
-  }
+  frame.pkg = pkg;
+  frame.entry = pkg->requires_entries;
+  frame.private = FALSE;
+  frame.pending = pull->pending->len;
 
-  return pkg;
+  g_array_append_val (pull->stack, frame);
+}
 
-quit:
+/* Record the requirement 'req' of the package on the top of the stack and
+ * move to its next requirement */
+static void
+package_link (Pull *pull, Package *req)
+{
+  PullFrame *frame;
+  guint edge;
 
-  g_hash_table_remove (packages, pkg->key);
+  frame = &g_array_index (pull->stack, PullFrame, pull->stack->len - 1);
 
-#if !GLIB_CHECK_VERSION(2,28,0)
-  package_free (pkg);
-#endif
+  required_versions_add (frame->pkg, frame->entry->data);
 
-  return NULL;
+  edge = GRAPH_EDGE (req->id, frame->private);
+  g_array_append_val (pull->pending, edge);
+
+  frame->entry = frame->entry->next;
 }
 
-gboolean
-package_pull_request (Package *pkg, Package *config, gboolean warn, gboolean ignore_uninstalled, gboolean *die)
+/* All requirements of the package on the top of the stack are in; move its
+ * edges to the graph, Requires.private first, and pop it */
+static Package *
+package_pop (Pull *pull)
 {
-  GList *iter;
+  PullFrame *frame;
+  Package *pkg;
+  guint start;
+  guint count;
+  guint edge;
+  guint i;
+
+  frame = &g_array_index (pull->stack, PullFrame, pull->stack->len - 1);
+  pkg = frame->pkg;
+
+  start = frame->pending;
+  count = pull->pending->len - start;
+
+  /* Copy the edges behind the pending ones, private edges first, keeping
+   * the order within both */
+  for ( i = 0; i < count; i++ )
+    {
+      edge = g_array_index (pull->pending, guint, start + i);
+      if ( GRAPH_EDGE_PRIVATE (edge) )
+        g_array_append_val (pull->pending, edge);
+    }
+
+  for ( i = 0; i < count; i++ )
+    {
+      edge = g_array_index (pull->pending, guint, start + i);
+      if ( !GRAPH_EDGE_PRIVATE (edge) )
+        g_array_append_val (pull->pending, edge);
+    }
+
+  graph_set_edges (pkg, &g_array_index (pull->pending, guint, start + count), count);
+
+  g_array_set_size (pull->pending, frame->pending);
+  g_array_set_size (pull->stack, pull->stack->len - 1);
+
+  trace_leave ( );
+
+  return pkg;
+}
+
+/* The requirement the package on the top of the stack is waiting for
+ * failed; so does the package and everything that's waiting for it */
+static void
+package_unwind (Pull *pull)
+{
+  PullFrame *frame;
   RequiredVersion *ver;
-  Package *req;
 
-  for (iter = pkg->requires_entries; iter != NULL; iter = iter->next)
+  while ( pull->stack->len > 0 )
     {
-      ver = iter->data;
+      frame = &g_array_index (pull->stack, PullFrame, pull->stack->len - 1);
+      ver = frame->entry->data;
 
-      debug_spew ("Searching for '%s' requirement '%s'\n", pkg->key, ver->name);
+      verbose_error ("Package '%s', required by '%s', not found\n", ver->name, frame->pkg->key);
 
-      req = package_get (config, ver->name, warn, ignore_uninstalled, die);
-      if (req == NULL)
-        {
-          verbose_error ("Package '%s', required by '%s', not found\n", ver->name, pkg->key);
+      /* We don't terminate the application using exit (die), but we
+       * release allocated memory for the package item and we don't continue
+       * in the process */
+      package_discard (frame->pkg);
 
-          /* We don't terminate the application using exit (die), but we
-           * release allocated memory for the package item and we don't continue
-           * in the process */
-          return FALSE;
-        }
+      g_array_set_size (pull->stack, pull->stack->len - 1);
 
-      required_versions_add (pkg, ver);
-      tail_list_add (&pkg->requires, req );
+      /* the requires span and the package span */
+      trace_leave ( );
+      trace_leave ( );
     }
-
-    return TRUE;
 }
 
-gboolean
-package_pull_request_private (Package *pkg, Package *config, gboolean warn, gboolean ignore_uninstalled, gboolean *die)
+/* Load a package and everything it requires. The requirements are pulled in
+ * depth first, in the order they are listed, using an explicit stack rather
+ * than recursion so long chains can't exhaust the C stack */
+Package *
+package_get (Package *pkg_config, const char *name, gboolean warn, gboolean ignore_uninstalled, gboolean *die)
 {
-  GList *iter;
+  Pull pull;
+  PullFrame *frame;
   RequiredVersion *ver;
+  Package *pkg;
   Package *req;
+  gboolean verified;
 
-  for ( iter = pkg->requires_private_entries; iter != NULL; iter = iter->next )
+  /* Package hash table has been created by the initialize funtion */
+  stats_count (STATS_LOOKUPS);
+  pkg = g_hash_table_lookup (packages, name);
+  if (pkg != NULL)
+    return pkg;
+
+  /* One span per package, covering its requirements, until verified */
+  trace_enter ("package", name);
+
+  pkg = package_create (pkg_config, name, warn, ignore_uninstalled, die );
+  if ( pkg == NULL )
     {
-      ver = iter->data;
+      trace_leave ( );
+      return NULL;
+    }
 
-      debug_spew ("Searching for '%s' private requirement '%s'\n", pkg->key, ver->name);
+  /* The -uninstalled variant may come back already pulled in */
+  if ( !graph_claim (pkg) )
+    {
+      trace_leave ( );
+      return pkg;
+    }
+
+  pull.stack = g_array_new (FALSE, FALSE, sizeof (PullFrame));
+  pull.pending = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  package_push (&pull, pkg, ignore_uninstalled);
+
+  while ( pull.stack->len > 0 )
+    {
+      frame = &g_array_index (pull.stack, PullFrame, pull.stack->len - 1);
 
-      req = package_get (config, ver->name, warn, ignore_uninstalled, die);
-      if (req == NULL)
+      /* pull in Requires packages, then Requires.private packages */
+      if ( frame->entry == NULL && !frame->private )
         {
-          verbose_error ("Package '%s', required by '%s', not found\n", ver->name, pkg->key);
+          frame->entry = frame->pkg->requires_private_entries;
+          frame->private = TRUE;
+          continue;
+        }
 
-          /* We don't terminate the application using exit (die), but we
-           * release allocated memory for the package item and we don't continue
-           * in the process */
-          return FALSE;
+      if ( frame->entry == NULL )
+        {
+          pkg = package_pop (&pull);
+
+          stats_enter (STATS_VERIFY);
+          trace_enter ("verify", "verify");
+          verified = package_verify (pkg, pkg_config);
+          trace_leave ( );
+          stats_leave ( );
+
+          /* the package span */
+          trace_leave ( );
+
+          if ( !verified )
+            {
+              *die = FALSE;
+
+              package_discard (pkg);
+              package_unwind (&pull);
+
+              pkg = NULL;
+              break;
+            }
+
+          if ( pull.stack->len > 0 )
+            package_link (&pull, pkg);
+
+          continue;
         }
 
-      required_versions_add (pkg, ver);
-      tail_list_add (&pkg->requires_private, req);
+      ver = frame->entry->data;
+
+      if ( frame->private )
+        debug_spew ("Searching for '%s' private requirement '%s'\n", frame->pkg->key, ver->name);
+      else
+        debug_spew ("Searching for '%s' requirement '%s'\n", frame->pkg->key, ver->name);
+
+      /* Already loaded or being loaded further down the stack */
+      stats_count (STATS_LOOKUPS);
+      req = g_hash_table_lookup (packages, ver->name);
+      if ( req != NULL )
+        {
+          package_link (&pull, req);
+          continue;
+        }
+
+      trace_enter ("package", ver->name);
+
+      req = package_create (pkg_config, ver->name, warn, ignore_uninstalled, die);
+      if ( req == NULL )
+        {
+          trace_leave ( );
+          package_unwind (&pull);
+
+          pkg = NULL;
+          break;
+        }
+
+      if ( graph_claim (req) )
+        package_push (&pull, req, ignore_uninstalled);
+      else
+        {
+          trace_leave ( );
+          package_link (&pull, req);
+        }
     }
 
-  return TRUE;
-}
+  g_array_free (pull.pending, TRUE);
+  g_array_free (pull.stack, TRUE);
 
+  return pkg;
+}
 
 #if !GLIB_CHECK_VERSION(2,28,0)
 
@@ -729,6 +937,8 @@ packages_add(Package *pkg)
 {
   debug_spew ("Adding '%s' package to list of known packages\n", pkg->key);
   g_hash_table_insert (packages, pkg->key, pkg);
+
+  graph_add_node (pkg);
 }
 
 Package *
@@ -739,12 +949,11 @@ package_create_virtual_pkgconfig (void)
   /* There is no package file installed so let's create new virtual package */
   debug_spew ("Creating virtual pkg-config package\n");
 
-  pkg_config = g_new0 (Package, 1);
-  pkg_config->key = g_strdup (def_name);
+  pkg_config = package_new (g_strdup (def_name));
   pkg_config->version = g_strdup (VERSION);
-  pkg_config->name = g_strdup (def_name);
-  pkg_config->description = g_strdup ("System package that allow querying of the compiler and linker flags");
-  pkg_config->url = g_strdup ("http://pkg-config.freedesktop.org");
+  pkg_config->info->name = g_strdup (def_name);
+  pkg_config->info->description = g_strdup ("System package that allow querying of the compiler and linker flags");
+  pkg_config->info->url = g_strdup ("http://pkg-config.freedesktop.org");
   pkg_config->virtual = TRUE;
 
   /* Get the built-in search path */
@@ -762,17 +971,7 @@ package_add_var (Package *pkg,
                 const char  *var,
                 const char  *val)
 {
-  char *newvar;
-  char *newval;
-
-  if (pkg->vars == NULL)
-    pkg->vars = g_hash_table_new (g_str_hash, g_str_equal);
-
-  newvar = strdup (var);
-  newval = strdup (val);
-
-  g_hash_table_insert (pkg->vars, (gpointer*) newvar,
-                       (gpointer*) newval);
+  var_map_set (&pkg->info->vars, var, g_strdup (val));
 }
 
 gboolean
@@ -791,20 +990,31 @@ package_add_pcpath (Package *pkg_config)
 gboolean
 package_uninstalled (Package *pkg)
 {
+  GList *requires;          /* List of package pointers */
   GList *iter;
+  gboolean uninstalled = FALSE;
 
   if (pkg->uninstalled)
     return TRUE;
 
-  for ( iter = pkg->requires.items; iter != NULL; iter = iter->next )
+  iter = g_list_prepend (NULL, pkg);
+  requires = graph_order (iter, FALSE);
+  g_list_free (iter);
+
+  for ( iter = requires; iter != NULL; iter = iter->next )
     {
       pkg = iter->data;
 
-      if (package_uninstalled (pkg))
-        return TRUE;
+      if (pkg->uninstalled)
+        {
+          uninstalled = TRUE;
+          break;
+        }
     }
 
-  return FALSE;
+  g_list_free (requires);
+
+  return uninstalled;
 }
 
 char *
@@ -817,6 +1027,8 @@ package_trim_and_sub (Package *pkg, Package *config, const char *str, const char
   char *temp;
   char *var_name;
 
+  stats_enter (STATS_EXPAND);
+
   trimmed = s_trim (str);
   subst = g_string_new ("");
 
@@ -855,10 +1067,15 @@ package_trim_and_sub (Package *pkg, Package *config, const char *str, const char
           /* Get up to close brace. */
           p = s_end_bracket (p);
           var_name = g_strndup (temp, p - temp);
-          p++;  /* Past brace */
+
+          /* An unterminated "${" takes the rest of the string as the
+           * name; don't step past the terminator */
+          if (*p == '}')
+            p++;  /* Past brace */
 
           /* We don't need this variable */
           temp = package_get_var_globals (pkg, config, var_name);
+          stats_count (STATS_VARIABLES_EXPANDED);
 
           if (temp == NULL)
             {
@@ -897,6 +1114,7 @@ package_trim_and_sub (Package *pkg, Package *config, const char *str, const char
   p = subst->str;
   g_string_free (subst, FALSE);
 
+  stats_leave ( );
   return p;
 
 quit:
@@ -904,6 +1122,7 @@ quit:
   g_free (trimmed);
   g_string_free (subst, TRUE);
 
+  stats_leave ( );
   return NULL;
 }
 
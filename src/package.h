@@ -21,32 +21,44 @@
 #define _PACKAGE_H_
 
 #include <glib.h>
+#include "flag.h"
 #include "taillist.h"
+#include "varmap.h"
 
 
+/* Package data that is rarely read once the .pc file has been parsed;
+ * allocated separately so it stays out of the way of the resolver */
 typedef struct
 {
-  char *key;  /* filename name */
   char *name; /* human-readable name */
-  char *version;
   char *description;
   char *url;
   char *pcfiledir; /* directory it was loaded from */
-  GList *requires_entries;           /* list of RequiredVersion items */
-  TailList requires;                 /* list of Package pointers */
-  GList *requires_private_entries;   /* list of RequiredVersion items */
-  TailList requires_private;         /* list of Package pointers */
-  TailList libs;                     /* list of Flag items */
-  TailList cflags;                   /* list of Flag items */
-  GHashTable *vars;                  /* hash from name to strings */
-  GHashTable *required_versions;     /* hash from name RequiredVersion and key pointers */
+  char *orig_prefix; /* original prefix value before redefinition */
+  char *digest; /* SHA-256 of the parsed lines, when parse_digest is set */
   GList *conflicts;                  /* list of RequiredVersion items */
-  gboolean uninstalled; /* used the -uninstalled file */
-  gboolean virtual; /* used for want_listing opt */
-  int path_position; /* used to order packages by position in path of their .pc file, lower number means earlier in path */
+  VarMap vars;                       /* variables defined by the .pc file */
   int libs_num; /* Number of times the "Libs" header has been seen */
   int libs_private_num;  /* Number of times the "Libs.private" header has been seen */
-  char *orig_prefix; /* original prefix value before redefinition */
+} PackageInfo;
+
+/* The part of a package walked while resolving and merging flags, laid out
+ * in two cache lines (on LP64): the first for the traversal, the second for
+ * the flags */
+typedef struct
+{
+  char *key;  /* filename name */
+  char *version;
+  guint id;                          /* number in the dependency graph, see graph.h */
+  int path_position; /* used to order packages by position in path of their .pc file, lower number means earlier in path */
+  guint uninstalled : 1; /* used the -uninstalled file */
+  guint virtual : 1; /* used for want_listing opt */
+  GList *requires_entries;           /* list of RequiredVersion items */
+  GList *requires_private_entries;   /* list of RequiredVersion items */
+  GHashTable *required_versions;     /* hash from name RequiredVersion and key pointers */
+  PackageInfo *info;
+  FlagSet libs;
+  FlagSet cflags;
 } Package;
 
 
@@ -60,6 +72,7 @@ typedef struct
 #endif // GLIB_CHECK_VERSION
 
 
+Package *package_new                    (char       *key);
 void     package_free_list              (GList      *list);
 void     package_free                   (Package    *pkg);
 Package *package_get                    (Package    *config,
@@ -91,9 +104,6 @@ Package * package_create_virtual_pkgconfig (void);
 void packages_add (Package *pkg);
 gboolean package_add_pcpath (Package *pkg_config);
 
-gboolean package_pull_request (Package *pkg, Package *config, gboolean warn, gboolean ignore_uninstalled, gboolean *die);
-gboolean package_pull_request_private (Package *pkg, Package *config, gboolean warn, gboolean ignore_uninstalled, gboolean *die);
-
 gboolean package_verify_required (Package *pkg);
 gboolean package_verify_requires_private (Package *pkg);
 
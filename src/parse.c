@@ -24,12 +24,16 @@
 #include "cflags.h"
 #include "libs.h"
 #include "package.h"
+#include "prefetch.h"
+#include "probes.h"
 #include "reqver.h"
+#include "stats.h"
 #include "strutil.h"
 #include "utils.h"
 
 
 gboolean parse_strict = TRUE;
+gboolean parse_digest = FALSE;
 gboolean define_prefix = ENABLE_DEFINE_PREFIX;
 char *prefix_variable = "prefix";
 
@@ -42,18 +46,50 @@ gboolean msvc_syntax = FALSE;
  * separated by commas and/or spaces. Commas are treated just like whitespace,
  * in order to allow stuff like: Requires: @FRIBIDI_PC@, glib, gmodule
  * where @FRIBIDI_PC@ gets substituted to nothing or to 'fribidi'
+ *
+ * The list is scanned in a single pass straight from the source text, either
+ * one string or the command line arguments. Arguments are read as if they
+ * were joined by single spaces, without joining them.
  */
 
+typedef struct
+{
+  char **strings;
+  int n_strings;
+} ModuleText;
+
+/* Position in a ModuleText; a token never spans two strings */
+typedef struct
+{
+  int index;
+  const char *p;
+} ModulePos;
+
+/* Known keywords, the order of the 'keywords' table */
 typedef enum
 {
-  /* put numbers to help interpret lame debug spew ;-) */
-  OUTSIDE_MODULE,
-  IN_MODULE_NAME,
-  BEFORE_OPERATOR,
-  IN_OPERATOR,
-  AFTER_OPERATOR,
-  IN_MODULE_VERSION
-} ModuleSplitState;
+  KEYWORD_NAME,
+  KEYWORD_DESCRIPTION,
+  KEYWORD_VERSION,
+  KEYWORD_REQUIRES_PRIVATE,
+  KEYWORD_REQUIRES,
+  KEYWORD_LIBS_PRIVATE,
+  KEYWORD_LIBS,
+  KEYWORD_CFLAGS,
+  KEYWORD_CFLAGS_ALT,
+  KEYWORD_CONFLICTS,
+  KEYWORD_URL,
+  KEYWORD_NONE
+} Keyword;
+
+/* ATTN: Returns FALSE when succeded; TRUE means die */
+typedef gboolean (*KeywordParser) (Package *pkg, Package *config, const char *str, const char *path);
+
+typedef struct
+{
+  const char *name;
+  KeywordParser parse;
+} KeywordInfo;
 
 
 /*
@@ -64,14 +100,14 @@ typedef enum
 static gboolean
 parse_name (Package *pkg, Package *config, const char *str, const char *path)
 {
-  if (pkg->name != NULL)
+  if (pkg->info->name != NULL)
     {
       verbose_error ("Name field occurs twice in '%s'\n", path);
       return parse_strict;
     }
 
-  pkg->name = package_trim_and_sub (pkg, config, str, path);
-  return pkg->name == NULL;
+  pkg->info->name = package_trim_and_sub (pkg, config, str, path);
+  return pkg->info->name == NULL;
 }
 
 /* ATTN: Returns FALSE when succeded; TRUE means die */
@@ -92,181 +128,239 @@ parse_version (Package *pkg, Package *config, const char *str, const char *path)
 static gboolean
 parse_description (Package *pkg, Package *config, const char *str, const char *path)
 {
-  if (pkg->description)
+  if (pkg->info->description)
     {
       verbose_error ("Description field occurs twice in '%s'\n", path);
       return parse_strict;
     }
 
-  pkg->description = package_trim_and_sub (pkg, config, str, path);
-  return pkg->description == NULL;
+  pkg->info->description = package_trim_and_sub (pkg, config, str, path);
+  return pkg->info->description == NULL;
 }
 
-static void
-add_module (TailList *list, const char *start, const char *end)
+/* Character at a position; the end of a string that isn't the last one
+ * reads as a space */
+static inline char
+module_char (const ModuleText *text, const ModulePos *pos)
 {
-  char *module;
+  if ( *pos->p == '\0' && pos->index + 1 < text->n_strings )
+    return ' ';
 
-  /* We left a module */
-  module = g_strndup (start, end - start);
+  return *pos->p;
+}
 
-#if HAVE_PARSE_SPEW
-  parse_spew ("Found module: '%s'\n", module);
-#endif
+/* Move past the current character, which must not be the end of the text */
+static inline void
+module_next (const ModuleText *text, ModulePos *pos)
+{
+  if ( *pos->p == '\0' )
+    {
+      pos->index++;
+      pos->p = text->strings[pos->index];
+    }
+  else
+    pos->p++;
+}
 
-  tail_list_add (list, module);
+static inline gboolean
+module_before (const ModulePos *a, const ModulePos *b)
+{
+  return a->index < b->index || (a->index == b->index && a->p < b->p);
 }
 
-/* List of duplicated strings */
+static inline void
+module_skip_space (const ModuleText *text, ModulePos *pos)
+{
+  while ( IS_SPACE (module_char (text, pos)) )
+    module_next (text, pos);
+}
+
+/* Where a module with a version specification ends: the operator characters,
+ * whatever single character follows them, any spaces, one more character and
+ * then everything up to the next separator */
+static ModulePos
+module_end (const ModuleText *text, ModulePos pos)
+{
+  char c;
+
+  for ( c = module_char (text, &pos); OPERATOR_CHAR (c); c = module_char (text, &pos) )
+    module_next (text, &pos);
+
+  if ( c == '\0' )
+    return pos;
+
+  module_next (text, &pos);
+  module_skip_space (text, &pos);
+
+  c = module_char (text, &pos);
+  if ( c == '\0' )
+    return pos;
+
+  module_next (text, &pos);
+
+  for ( c = module_char (text, &pos); c != '\0' && !MODULE_SEPARATOR (c); c = module_char (text, &pos) )
+    module_next (text, &pos);
+
+  return pos;
+}
+
+/* Returns RequiredVersion item list; ATTN: die is set to FALSE when succeded */
 static GList *
-split_module_list (const char *str, const char *path)
+parse_modules (Package *pkg, const ModuleText *text, const char *path, gboolean *die)
 {
   TailList retval;
-  const char *end;
-  const char *start;
-  ModuleSplitState state = OUTSIDE_MODULE;
-  ModuleSplitState last_state = OUTSIDE_MODULE;
-  char *temp;
+  ModulePos pos, name, op, end;
+  const char *version;
+  gsize name_len, op_len, version_len;
+  ComparisonType comparison;
+  gboolean trailing = FALSE;
   char c;
 
-#if HAVE_PARSE_SPEW
-  parse_spew ( "Parsing: '%s'\n", str);
-#endif
-
   tail_list_init (retval);
-  start = end = str;
-
-  for ( c = *end; c != '\0'; c = *++end, last_state = state )
-    {
-#if HAVE_PARSE_SPEW
-      parse_spew ("  char>%c [state: %d last state: %d]\n", c, state, last_state);
-#endif
 
-      switch (state)
-        {
-        case OUTSIDE_MODULE:
+  *die = FALSE;
+  if ( text->n_strings == 0 )
+    return NULL;
 
-          if (!MODULE_SEPARATOR (c))
-            state = IN_MODULE_NAME;
+  pos.index = 0;
+  pos.p = text->strings[0];
 
-          break;
+  while ( TRUE )
+    {
+      /* Separators before the module; a comma not followed by a module is
+       * an empty package name */
+      for ( c = module_char (text, &pos); MODULE_SEPARATOR (c); c = module_char (text, &pos) )
+        {
+          if ( c == ',' )
+            trailing = TRUE;
 
-        case IN_MODULE_NAME:
+          module_next (text, &pos);
+        }
 
-          if ( IS_SPACE (c) )
-            {
-              /* Need to look ahead to determine next state; +1 because we know
-               * the character is a space so we can move to the next character */
-              temp = s_space (end + 1);
-
-              c = *temp;
-              if (c == '\0')
-                state = OUTSIDE_MODULE;
-              else if (MODULE_SEPARATOR (c))
-                state = OUTSIDE_MODULE;
-              else if (OPERATOR_CHAR (c))
-                state = BEFORE_OPERATOR;
-              else
-                state = OUTSIDE_MODULE;
-            }
-          else if (MODULE_SEPARATOR (c))
-            state = OUTSIDE_MODULE; /* comma precludes any operators */
+      if ( c == '\0' )
+        break;
 
-          break;
+      trailing = FALSE;
 
-        case BEFORE_OPERATOR:
+      /* Name */
+      name = pos;
+      for ( ; c != '\0' && !MODULE_SEPARATOR (c); c = module_char (text, &pos) )
+        module_next (text, &pos);
 
-          /* We know an operator is coming up here due to lookahead from
-           * IN_MODULE_NAME
-           */
-          if (IS_SPACE (c))
-            ; /* no change */
-          else if (OPERATOR_CHAR (c))
-            state = IN_OPERATOR;
-          else
-            g_assert_not_reached ();
+      name_len = pos.p - name.p;
+      comparison = ALWAYS_MATCH;
+      version = NULL;
+      version_len = 0;
 
-          break;
+      /* A comma precludes any operator; after spaces look ahead for one */
+      if ( IS_SPACE (c) )
+        {
+          op = pos;
+          module_skip_space (text, &op);
 
-        case IN_OPERATOR:
+          if ( OPERATOR_CHAR (module_char (text, &op)) )
+            {
+              end = module_end (text, op);
 
-          if (!OPERATOR_CHAR (c))
-            state = AFTER_OPERATOR;
+              /* Operator: up to a space */
+              pos = op;
+              while ( module_before (&pos, &end) && !IS_SPACE (module_char (text, &pos)) )
+                module_next (text, &pos);
 
-          break;
+              op_len = pos.p - op.p;
 
-        case AFTER_OPERATOR:
+              /* Version: up to a separator */
+              while ( module_before (&pos, &end) && IS_SPACE (module_char (text, &pos)) )
+                module_next (text, &pos);
 
-          if (!IS_SPACE (c))
-            state = IN_MODULE_VERSION;
+              version = pos.p;
+              while ( module_before (&pos, &end) && !MODULE_SEPARATOR (module_char (text, &pos)) )
+                module_next (text, &pos);
 
-          break;
+              version_len = pos.p - version;
+              pos = end;
 
-        case IN_MODULE_VERSION:
+              comparison = parse_comparison_type (op.p, op_len);
+              if ( comparison == UNKNOWN )
+                {
+                  verbose_error ("Unknown version comparison operator '%.*s' after "
+                                 "package name '%.*s' in file '%s'\n", (int) op_len, op.p,
+                                 (int) name_len, name.p, path);
 
-          if (MODULE_SEPARATOR (c))
-            state = OUTSIDE_MODULE;
+                  if ( parse_strict )
+                    goto failed;
 
-          break;
+                  version = NULL;
+                }
+              else if ( version_len == 0 )
+                {
+                  verbose_error ("Comparison operator but no version after package "
+                                 "name '%.*s' in file '%s'\n", (int) name_len, name.p, path);
 
-        default:
+                  if ( parse_strict )
+                    goto failed;
 
-          g_assert_not_reached ();
+                  version = "0";
+                  version_len = 1;
+                }
+            }
         }
 
-      if (state != OUTSIDE_MODULE || last_state == OUTSIDE_MODULE)
-        continue;
-
-      /* We left a module */
-      add_module (&retval, start, end);
+#if HAVE_PARSE_SPEW
+      parse_spew ("Found module: '%.*s' %s '%.*s'\n", (int) name_len, name.p,
+                  comparison_to_str (comparison), (int) version_len,
+                  version != NULL ? version : "");
+#endif
 
-      /* reset start */
-      start = end;
+      tail_list_add (&retval, required_version_new (pkg, name.p, name_len, comparison,
+                                                    version, version_len));
     }
 
-  /* Get the last module */
-  if ( start != end )
+  if ( trailing )
     {
-      add_module (&retval, start, end);
+      verbose_error ("Empty package name in Requires or Conflicts in file '%s'\n", path);
+
+      if ( parse_strict )
+        goto failed;
     }
 
   return retval.items;
+
+failed:
+
+  required_version_free_list (retval.items);
+
+  *die = TRUE;
+  return NULL;
 }
 
 /* Returns RequiredVersion item list; ATTN: die is set to FALSE when succeded */
 GList *
 parse_module_list (Package *pkg, Package *config, const char *str, const char *path, gboolean *die)
 {
-  GList *split;
-  GList *iter;
-  TailList retval;
-  RequiredVersion *ver;
-
-  tail_list_init (retval);
-  split = split_module_list (str, path);
+  ModuleText text;
 
-  for ( iter = split; iter != NULL; iter = iter->next )
-    {
-      ver = required_version_create (pkg);
+#if HAVE_PARSE_SPEW
+  parse_spew ( "Parsing: '%s'\n", str);
+#endif
 
-      /* ATTN: The result value does not mean success, but that the application should die*/
-      if ( required_version_parse (ver, iter->data, path) )
-        {
-          required_version_free (ver);
-          required_version_free_list (retval.items);
-          free_list (split);
+  text.strings = (char **) &str;
+  text.n_strings = 1;
 
-          *die = TRUE;
-          return NULL;
-        }
+  return parse_modules (pkg, &text, path, die);
+}
 
-      tail_list_add (&retval, ver);
-    }
+/* Same as parse_module_list for a list given as separate arguments, which
+ * are taken as if joined by spaces */
+GList *
+parse_module_args (Package *pkg, int argc, char **argv, const char *path, gboolean *die)
+{
+  ModuleText text;
 
-  free_list (split);
+  text.strings = argv;
+  text.n_strings = argc;
 
-  *die = FALSE;
-  return retval.items;
+  return parse_modules (pkg, &text, path, die);
 }
 
 /* ATTN: Returns FALSE when succeded; TRUE means die */
@@ -276,11 +370,9 @@ parse_requires (Package *pkg, Package *config, const char *str, const char *path
   char *trimmed;
   gboolean die;
 
-  if ( pkg->requires.items != NULL )
-    {
-      verbose_error ("Requires field occurs twice in '%s'\n", path);
-      return parse_strict;
-    }
+  /* A repeated field replaces the earlier one */
+  required_version_free_list (pkg->requires_entries);
+  pkg->requires_entries = NULL;
 
   trimmed = package_trim_and_sub (pkg, config, str, path);
   if (trimmed == NULL)
@@ -299,11 +391,9 @@ parse_requires_private (Package *pkg, Package *config, const char *str, const ch
   char *trimmed;
   gboolean die;
 
-  if ( pkg->requires_private.items != NULL )
-    {
-      verbose_error ("Requires.private field occurs twice in '%s'\n", path);
-      return parse_strict;
-    }
+  /* A repeated field replaces the earlier one */
+  required_version_free_list (pkg->requires_private_entries);
+  pkg->requires_private_entries = NULL;
 
   trimmed = package_trim_and_sub (pkg, config, str, path);
   if (trimmed == NULL)
@@ -322,7 +412,7 @@ parse_conflicts (Package *pkg, Package *config, const char *str, const char *pat
   char *trimmed;
   gboolean die;
 
-  if (pkg->conflicts)
+  if (pkg->info->conflicts)
     {
       verbose_error ("Conflicts field occurs twice in '%s'\n", path);
       return parse_strict;
@@ -332,7 +422,7 @@ parse_conflicts (Package *pkg, Package *config, const char *str, const char *pat
   if (trimmed == NULL)
     return TRUE;
 
-  pkg->conflicts = parse_module_list (pkg, config, trimmed, path, &die);
+  pkg->info->conflicts = parse_module_list (pkg, config, trimmed, path, &die);
   g_free (trimmed);
 
   return die;
@@ -342,76 +432,126 @@ parse_conflicts (Package *pkg, Package *config, const char *str, const char *pat
 static gboolean
 parse_url (Package *pkg, Package *config, const char *str, const char *path)
 {
-  if (pkg->url != NULL)
+  if (pkg->info->url != NULL)
     {
       verbose_error ("URL field occurs twice in '%s'\n", path);
       return parse_strict;
     }
 
-  pkg->url = package_trim_and_sub (pkg, config, str, path);
-  return pkg->url == NULL;
+  pkg->info->url = package_trim_and_sub (pkg, config, str, path);
+  return pkg->info->url == NULL;
 }
 
-static gboolean
-parse_keyword (Package *pkg, Package *config, const char *path,
-    const char *tag, const char *value, gboolean ignore_requires,
-    gboolean ignore_private_libs, gboolean ignore_requires_private)
+static const KeywordInfo keywords[] =
 {
-  value = s_space (value);
+  { "Name",             parse_name },
+  { "Description",      parse_description },
+  { "Version",          parse_version },
+  { "Requires.private", parse_requires_private },
+  { "Requires",         parse_requires },
+  { "Libs.private",     libs_parse_private },
+  { "Libs",             libs_parse },
+  { "Cflags",           cflags_parse },
+  { "CFlags",           cflags_parse },
+  { "Conflicts",        parse_conflicts },
+  { "URL",              parse_url }
+};
+
+/* Perfect hash of the keywords: the length and at most two characters pick
+ * the only candidate, which is then compared once */
+static Keyword
+keyword_lookup (const char *tag, gsize len)
+{
+  Keyword kw;
 
-  if (strcmp (tag, "Name") == 0)
-    return parse_name (pkg, config, value, path);
+  switch (len)
+    {
+    case 3:
+      kw = KEYWORD_URL;
+      break;
 
-  if (strcmp (tag, "Description") == 0)
-    return parse_description (pkg, config, value, path);
+    case 4:
+      kw = tag[0] == 'N' ? KEYWORD_NAME : KEYWORD_LIBS;
+      break;
 
-  if (strcmp (tag, "Version") == 0)
-    return parse_version (pkg, config, value, path);
+    case 6:
+      kw = tag[1] == 'F' ? KEYWORD_CFLAGS_ALT : KEYWORD_CFLAGS;
+      break;
 
-  if (strcmp (tag, "Requires.private") == 0)
-    {
-      if (ignore_requires_private)
-        return FALSE;
+    case 7:
+      kw = KEYWORD_VERSION;
+      break;
 
-      return parse_requires_private (pkg, config, value, path);
-    }
+    case 8:
+      kw = KEYWORD_REQUIRES;
+      break;
 
-  if (strcmp (tag, "Requires") == 0)
-    {
-      if (ignore_requires)
-        return FALSE;
+    case 9:
+      kw = KEYWORD_CONFLICTS;
+      break;
 
-      return parse_requires (pkg, config, value, path);
-    }
+    case 11:
+      kw = KEYWORD_DESCRIPTION;
+      break;
 
-  if ( strcmp (tag, "Libs.private") == 0 )
-    {
-      if (ignore_private_libs)
-         return FALSE;
+    case 12:
+      kw = KEYWORD_LIBS_PRIVATE;
+      break;
+
+    case 16:
+      kw = KEYWORD_REQUIRES_PRIVATE;
+      break;
 
-      return libs_parse_private (pkg, config, value, path);
+    default:
+      return KEYWORD_NONE;
     }
 
-  if (strcmp (tag, "Libs") == 0)
-    return libs_parse (pkg, config, value, path);
+  if ( memcmp (tag, keywords[kw].name, len) != 0 )
+    return KEYWORD_NONE;
 
-  if (strcmp (tag, "Cflags") == 0 ||
-      strcmp (tag, "CFlags") == 0)
-    return cflags_parse (pkg, config, value, path);
+  return kw;
+}
 
-  if (strcmp (tag, "Conflicts") == 0)
-    return parse_conflicts (pkg, config, value, path);
+/* ATTN: Returns FALSE when succeded; TRUE means die */
+static gboolean
+parse_keyword (Package *pkg, Package *config, const char *path,
+    const char *tag, gsize tag_len, const char *value, gboolean ignore_requires,
+    gboolean ignore_private_libs, gboolean ignore_requires_private)
+{
+  Keyword kw;
 
-  if (strcmp (tag, "URL") == 0)
-    return parse_url (pkg, config, value, path);
+  kw = keyword_lookup (tag, tag_len);
+  switch (kw)
+    {
+    case KEYWORD_NONE:
+      /* we don't error out on unknown keywords because they may
+       * represent additions to the .pc file format from future
+       * versions of pkg-config.  We do make a note of them in the
+       * debug spew though, in order to help catch mistakes in .pc
+       * files. */
+      debug_spew ("Unknown keyword '%s' in '%s'\n", tag, path);
+      return FALSE;
+
+    case KEYWORD_REQUIRES_PRIVATE:
+      if (ignore_requires_private)
+        return FALSE;
+      break;
+
+    case KEYWORD_REQUIRES:
+      if (ignore_requires)
+        return FALSE;
+      break;
+
+    case KEYWORD_LIBS_PRIVATE:
+      if (ignore_private_libs)
+        return FALSE;
+      break;
 
-  /* we don't error out on unknown keywords because they may
-   * represent additions to the .pc file format from future
-   * versions of pkg-config.  We do make a note of them in the
-   * debug spew though, in order to help catch mistakes in .pc
-   * files. */
-  debug_spew ("Unknown keyword '%s' in '%s'\n", tag, path);
-  return FALSE;
+    default:
+      break;
+    }
+
+  return keywords[kw].parse (pkg, config, s_space (value), path);
 }
 
 static int
@@ -422,7 +562,7 @@ parse_prefix_variable (Package *pkg, const char *tag, const char *prefix)
 
   /* This is the prefix variable. Try to guesstimate a value for it
    * for this package from the location of the .pc file. */
-  value = g_path_get_basename (pkg->pcfiledir);
+  value = g_path_get_basename (pkg->info->pcfiledir);
 
   if ( g_ascii_strcasecmp (value, "pkgconfig") != 0 )
     {
@@ -434,10 +574,10 @@ parse_prefix_variable (Package *pkg, const char *tag, const char *prefix)
   g_free (value);
 
   /* Keep track of the original prefix value. */
-  pkg->orig_prefix = g_strdup (prefix);
+  pkg->info->orig_prefix = g_strdup (prefix);
 
   /* Get grandparent directory for new prefix. */
-  temp = g_path_get_dirname (pkg->pcfiledir);
+  temp = g_path_get_dirname (pkg->info->pcfiledir);
   value = g_path_get_dirname (temp);
   g_free (temp);
 
@@ -447,13 +587,11 @@ parse_prefix_variable (Package *pkg, const char *tag, const char *prefix)
 
   /* Now escape the special characters so that there's no danger
   * of arguments that include the prefix getting split. */
-  temp = s_dup_escape_shell (value);
-  g_free (value);
+  temp = s_escape_shell (value);
 
   debug_spew (" Variable declaration, '%s' overridden with '%s'\n", tag, temp);
 
-  value = g_strdup (tag);
-  g_hash_table_insert (pkg->vars, value, temp);
+  var_map_set (&pkg->info->vars, tag, temp);
 
   return TRUE;
 }
@@ -466,111 +604,125 @@ parse_orig_prefix (Package *pkg, const char *prefix)
   char *varval;
 	char c;
 
-  if (pkg->orig_prefix == NULL)
+  if (pkg->info->orig_prefix == NULL)
     return NULL;
 
-  len = strlen (pkg->orig_prefix);
-  if ( len == 0 )		/* ~ pkg->orig_prefix[0] == '\0' ~ *(pkg->orig_prefix) == '\0' */
+  len = strlen (pkg->info->orig_prefix);
+  if ( len == 0 )		/* ~ pkg->info->orig_prefix[0] == '\0' ~ *(pkg->info->orig_prefix) == '\0' */
     return NULL;
 
-  if ( strncmp (pkg->orig_prefix, prefix, len) != 0 )
+  if ( strncmp (pkg->info->orig_prefix, prefix, len) != 0 )
     return NULL;
 
   c = prefix [len];
   if ( !G_IS_DIR_SEPARATOR (c) )
     return NULL;
 
-  varval = g_hash_table_lookup (pkg->vars, prefix_variable);
+  varval = var_map_get (&pkg->info->vars, prefix_variable);
   return g_strconcat (varval, prefix + len, NULL);
 }
 
+/* Parses the line in place; 'line' is modified
+ * ATTN: Returns FALSE when succeded; TRUE means die */
 static gboolean
-parse_line (Package *pkg, Package *config, const char *untrimmed,
+parse_line (Package *pkg, Package *config, char *line, gsize len,
         const char *path, gboolean ignore_requires,
         gboolean ignore_private_libs, gboolean ignore_requires_private)
 {
   char *str, *tag, *end;
-  char *newval;
+  char *newval = NULL;
+  gsize tag_len;
   char c;
-  gboolean die;
+  gboolean die = FALSE;
 
-  debug_spew ("  line>%s\n", untrimmed);
+  debug_spew ("  line>%s\n", line);
 
-  str = s_trim (untrimmed);
+  /* Trim the line */
+  while ( len > 0 && IS_SPACE (line[len - 1]) )
+    line[--len] = '\0';
 
-  end = s_valid (str);
-  if ( str == end )   /* empty line */
-    {
-      g_free (str);
-      return FALSE;
-    }
+  tag = s_space (line);
+  end = s_valid (tag);
+  if ( tag == end )   /* empty line */
+    return FALSE;
+
+  tag_len = end - tag;
+  str = s_space (end);
 
-  die = FALSE;
-  tag = g_strndup (str, end - str);
-  end = s_space (end);
+  /* The tag gets terminated in place once the character following it is known */
+  c = *str;
+  *end = '\0';
 
-  c = *end;
   if (c == ':')
     {
       /* keyword */
-      die = parse_keyword (pkg, config, path, tag, end + 1, ignore_requires,
-                          ignore_private_libs, ignore_requires_private);
+      return parse_keyword (pkg, config, path, tag, tag_len, str + 1, ignore_requires,
+                            ignore_private_libs, ignore_requires_private);
     }
-  else if (c == '=')
-    {
-      end = s_space (end + 1);
 
-      if ( define_prefix )
+  if (c != '=')
+    return FALSE;
+
+  str = s_space (str + 1);
+
+  if ( define_prefix )
+    {
+      if ( strcmp (tag, prefix_variable) == 0)
         {
-          if ( strcmp (tag, prefix_variable) == 0)
-            {
-              if ( parse_prefix_variable (pkg, tag, end) )
-                goto cleanup;
-            }
-          else
-            {
-              newval = parse_orig_prefix (pkg, end);
-              if ( newval != NULL )
-                {
-                  g_free (str);
-                  str = end = newval;
-                }
-            }
+          if ( parse_prefix_variable (pkg, tag, str) )
+            return FALSE;
         }
-
-      if ( g_hash_table_lookup (pkg->vars, tag) != NULL )
+      else
         {
-          verbose_error ("Duplicate definition of variable '%s' in '%s'\n",
-                         tag, path);
-
-          if (parse_strict)
-            {
-              die = TRUE;
-              goto cleanup;
-            }
+          newval = parse_orig_prefix (pkg, str);
+          if ( newval != NULL )
+            str = newval;
         }
+    }
+
+  if ( var_map_get (&pkg->info->vars, tag) != NULL )
+    {
+      verbose_error ("Duplicate definition of variable '%s' in '%s'\n",
+                     tag, path);
 
-      newval = package_trim_and_sub (pkg, config, end, path);
-      if (newval == NULL)
+      if (parse_strict)
         {
           die = TRUE;
           goto cleanup;
         }
+    }
 
-      debug_spew (" Variable declaration, '%s' has value '%s'\n",
-                  tag, newval);
-
-      end = g_strdup (tag);
-      g_hash_table_insert (pkg->vars, end, newval);
+  end = package_trim_and_sub (pkg, config, str, path);
+  if (end == NULL)
+    {
+      die = TRUE;
+      goto cleanup;
     }
 
+  debug_spew (" Variable declaration, '%s' has value '%s'\n",
+              tag, end);
+
+  var_map_set (&pkg->info->vars, tag, end);
+
 cleanup:
 
-  g_free (tag);
-  g_free (str);
+  g_free (newval);
   return die;
 }
 
+/* read_one_line, timed as reading */
+static gboolean
+parse_read_line (FILE *f, GString *str)
+{
+  gboolean more;
+
+  stats_enter (STATS_READ);
+  more = read_one_line (f, str);
+  stats_leave ( );
+
+  return more;
+}
+
 Package*
 parse_package_file (const char *key, const char *path,
                     Package *pkg_config,
@@ -582,9 +734,18 @@ parse_package_file (const char *key, const char *path,
   FILE *f;
   Package *pkg;
   GString *str;
+  GChecksum *checksum = NULL;
+  gboolean uses_pcfiledir = FALSE;
   gboolean one_line = FALSE;
+  guint lines = 0;
+
+  probe1 (parse__start, path);
+
+  stats_enter (STATS_PARSE);
 
-  f = fopen (path, "r");
+  stats_enter (STATS_READ);
+  f = prefetch_open (path);
+  stats_leave ( );
 
   if (f == NULL)
     {
@@ -592,34 +753,53 @@ parse_package_file (const char *key, const char *path,
 
       /* 'parse_strict' boolean is relevant only when return value is null */
       *die = FALSE;
+
+      probe3 (parse__done, path, -1L, 0);
+      stats_leave ( );
       return NULL;
     }
 
+  stats_count (STATS_FILES_OPENED);
+
   debug_spew ("Parsing package file '%s'\n", path);
 
-  pkg = g_new0 (Package, 1);
-  pkg->key = g_strdup (key);
+  pkg = package_new (g_strdup (key));
 
   if ( path != NULL )
     {
-      pkg->pcfiledir = g_path_get_dirname (path);
+      pkg->info->pcfiledir = g_path_get_dirname (path);
     }
   else
     {
       debug_spew ("No pcfiledir determined for package\n");
-      pkg->pcfiledir = g_strdup ("???????");
+      pkg->info->pcfiledir = g_strdup ("???????");
     }
 
   /* Variable storing directory of pc file */
-  package_add_var (pkg, "pcfiledir", pkg->pcfiledir);
+  package_add_var (pkg, "pcfiledir", pkg->info->pcfiledir);
 
   str = g_string_new ("");
 
-  while (read_one_line (f, str))
+  if (parse_digest)
+    checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+  while (parse_read_line (f, str))
     {
       one_line = TRUE;
+      lines++;
+      stats_count (STATS_LINES_PARSED);
 
-      if ( parse_line (pkg, pkg_config, str->str, path, ignore_requires,
+      /* Lines as read, without comments, and not the empty ones: edits
+       * to comments and blank lines don't count. The terminator keeps the
+       * line boundaries */
+      if (checksum != NULL && str->len > 0)
+        {
+          g_checksum_update (checksum, (const guchar *) str->str, str->len + 1);
+          if (!uses_pcfiledir && strstr (str->str, "pcfiledir") != NULL)
+            uses_pcfiledir = TRUE;
+        }
+
+      if ( parse_line (pkg, pkg_config, str->str, str->len, path, ignore_requires,
             ignore_private_libs, ignore_requires_private) )
         goto quit;
 
@@ -629,9 +809,25 @@ parse_package_file (const char *key, const char *path,
   if (!one_line)
     verbose_error ("Package file '%s' appears to be empty\n", path);
 
+  /* The flags depend on the location only through ${pcfiledir} or a
+   * prefix guessed from it */
+  if (checksum != NULL)
+    {
+      if (uses_pcfiledir || define_prefix)
+        g_checksum_update (checksum, (const guchar *) pkg->info->pcfiledir,
+                           strlen (pkg->info->pcfiledir) + 1);
+
+      pkg->info->digest = g_strdup (g_checksum_get_string (checksum));
+      g_checksum_free (checksum);
+    }
+
+  probe3 (parse__done, path, ftell (f), lines);
+
   g_string_free (str, TRUE);
   fclose(f);
 
+  stats_leave ( );
+
   /* No need to set 'die' boolean because package is not null */
   return pkg;
 
@@ -639,9 +835,16 @@ quit:
 
   package_free ( pkg );
 
+  if (checksum != NULL)
+    g_checksum_free (checksum);
+
+  probe3 (parse__done, path, ftell (f), lines);
+
   g_string_free (str, TRUE);
   fclose(f);
 
+  stats_leave ( );
+
   *die = TRUE;
   return NULL;
 }
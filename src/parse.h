@@ -20,18 +20,19 @@
 #ifndef _PARSE_H_
 #define _PARSE_H_
 
+#include "charclass.h"
 #include "package.h"
 
 
-#define OPERATOR_CHAR(c)    ((c) == '<' || (c) == '>' || (c) == '!' || (c) == '=')
+#define OPERATOR_CHAR(c)    CC_IS (c, CC_OPERATOR)
 
-#define IS_SPACE(c)         (isspace ((guchar)(c)))
-#define MODULE_SEPARATOR(c) ((c) == ',' || IS_SPACE(c))
-#define IS_VALID_CHAR(c)    (((c) >= 'A' && (c) <= 'Z') || ((c) >= 'a' && (c) <= 'z') \
-                          || ((c) >= '0' && (c) <= '9') || (c) == '_' || (c) == '.')
+#define IS_SPACE(c)         CC_IS (c, CC_SPACE)
+#define MODULE_SEPARATOR(c) CC_IS (c, CC_MODULE_SEP)
+#define IS_VALID_CHAR(c)    CC_IS (c, CC_VALID)
 
 
 extern gboolean parse_strict;
+extern gboolean parse_digest;
 
 
 Package *parse_package_file (const char *key, const char *path,
@@ -47,6 +48,12 @@ GList   *parse_module_list (Package *pkg,
                             const char *path,
                             gboolean *die);
 
+GList   *parse_module_args (Package *pkg,
+                            int argc,
+                            char **argv,
+                            const char *path,
+                            gboolean *die);
+
 char * parse_package_variable (Package *pkg, Package *config, const char *variable);
 
 
@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include "prefetch.h"
+#include "globals.h"
+#include "inputs.h"
+#include "reqver.h"
+#include "strutil.h"
+#include "utils.h"
+
+
+typedef struct
+{
+  char *name;
+  char *location;               /* NULL when not found in the search path */
+  unsigned int path_position;
+  char *contents;               /* NULL when the file couldn't be read */
+  gsize length;
+  Input snapshot;               /* stat taken before the read */
+  gboolean done;
+} Prefetch;
+
+
+static GThreadPool *pool = NULL;
+
+/* Array owning all Prefetch items */
+static GPtrArray *items = NULL;
+
+/* Hash tables with Prefetch item pointers; keys are owned by the items */
+static GHashTable *by_name = NULL;
+static GHashTable *by_location = NULL;
+
+/* Protects the 'done' flag and the results of every item */
+static GMutex lock;
+static GCond finished;
+
+
+/*
+ * Code
+ */
+
+static void
+prefetch_worker (gpointer data, gpointer user_data)
+{
+  Prefetch *item = data;
+  char *location;
+  unsigned int path_position = 0;
+  char *contents = NULL;
+  gsize length = 0;
+
+  location = file_find_in_search_dirs (item->name, &path_position);
+  if ( location != NULL )
+    {
+      input_stat (&item->snapshot, location, FALSE);
+
+      if ( !g_file_get_contents (location, &contents, &length, NULL) )
+        contents = NULL;
+    }
+
+  g_mutex_lock (&lock);
+
+  item->location = location;
+  item->snapshot.path = location;
+  item->path_position = path_position;
+  item->contents = contents;
+  item->length = length;
+  item->done = TRUE;
+
+  g_cond_broadcast (&finished);
+  g_mutex_unlock (&lock);
+}
+
+static void
+prefetch_free (Prefetch *item)
+{
+  g_free (item->name);
+  g_free (item->location);
+  g_free (item->contents);
+  g_free (item);
+}
+
+static void
+prefetch_init_tables (void)
+{
+  if ( items != NULL )
+    return;
+
+  g_mutex_init (&lock);
+  g_cond_init (&finished);
+
+  items = g_ptr_array_new_with_free_func ((GDestroyNotify) prefetch_free);
+  by_name = g_hash_table_new (g_str_hash, g_str_equal);
+  by_location = g_hash_table_new (g_str_hash, g_str_equal);
+}
+
+static gboolean
+prefetch_init (void)
+{
+  if ( pool != NULL )
+    return TRUE;
+
+  if ( prefetch_threads <= 0 )
+    return FALSE;
+
+  pool = g_thread_pool_new (prefetch_worker, NULL, prefetch_threads, FALSE, NULL);
+  if ( pool == NULL )
+    {
+      prefetch_threads = 0;
+      return FALSE;
+    }
+
+  prefetch_init_tables ( );
+  return TRUE;
+}
+
+/* Collect a name worth fetching: not loaded yet, not queued yet and not a
+ * file name (those are opened directly by package_create) */
+static void
+prefetch_collect (GPtrArray *names, const char *name)
+{
+  if ( g_hash_table_lookup (packages, name) != NULL )
+    return;
+
+  if ( by_name != NULL && g_hash_table_lookup (by_name, name) != NULL )
+    return;
+
+  if ( ends_in_dotpc (name) )
+    return;
+
+  g_ptr_array_add (names, g_strdup (name));
+}
+
+static void
+prefetch_collect_list (GPtrArray *names, GList *entries, gboolean ignore_uninstalled)
+{
+  GList *iter;
+  RequiredVersion *ver;
+  char *un;
+
+  for ( iter = entries; iter != NULL; iter = iter->next )
+    {
+      ver = iter->data;
+
+      /* package_create probes the -uninstalled variant first */
+      if ( !ignore_uninstalled && !name_ends_in_uninstalled (ver->name) )
+        {
+          un = g_strconcat (ver->name, "-uninstalled", NULL);
+          prefetch_collect (names, un);
+          g_free (un);
+        }
+
+      prefetch_collect (names, ver->name);
+    }
+}
+
+void
+prefetch_requires (Package *pkg, gboolean ignore_uninstalled)
+{
+  GPtrArray *names;
+  Prefetch *item;
+  guint i;
+
+  if ( prefetch_threads <= 0 )
+    return;
+
+  names = g_ptr_array_new ( );
+
+  prefetch_collect_list (names, pkg->requires_entries, ignore_uninstalled);
+  prefetch_collect_list (names, pkg->requires_private_entries, ignore_uninstalled);
+
+  /* The first lookup is needed right away; a single one gains nothing */
+  if ( names->len < 2 || !prefetch_init ( ) )
+    {
+      for ( i = 0; i < names->len; i++ )
+        g_free (g_ptr_array_index (names, i));
+
+      g_ptr_array_free (names, TRUE);
+      return;
+    }
+
+  debug_spew ("Prefetching %u requirements of '%s'\n", names->len, pkg->key);
+
+  for ( i = 0; i < names->len; i++ )
+    {
+      item = g_new0 (Prefetch, 1);
+      item->name = g_ptr_array_index (names, i);
+
+      /* A name may appear in both lists */
+      if ( g_hash_table_lookup (by_name, item->name) != NULL )
+        {
+          prefetch_free (item);
+          continue;
+        }
+
+      g_ptr_array_add (items, item);
+      g_hash_table_insert (by_name, item->name, item);
+      g_thread_pool_push (pool, item, NULL);
+    }
+
+  g_ptr_array_free (names, TRUE);
+}
+
+/* Same as file_find_in_search_dirs but takes a prefetched result when there
+ * is one, waiting for it if the worker hasn't finished yet */
+char *
+prefetch_find (const char *name, unsigned int *path_position)
+{
+  Prefetch *item;
+  char *location;
+
+  if ( pool == NULL )
+    return file_find_in_search_dirs (name, path_position);
+
+  item = g_hash_table_lookup (by_name, name);
+  if ( item == NULL )
+    return file_find_in_search_dirs (name, path_position);
+
+  g_mutex_lock (&lock);
+
+  while ( !item->done )
+    g_cond_wait (&finished, &lock);
+
+  g_mutex_unlock (&lock);
+
+  if ( item->location == NULL )
+    return NULL;
+
+  *path_position = item->path_position;
+  location = g_strdup (item->location);
+
+  /* parse_package_file will ask for the contents by location */
+  if ( item->contents != NULL )
+    g_hash_table_replace (by_location, item->location, item);
+
+  return location;
+}
+
+/* Open a .pc file, from memory when it has been prefetched already */
+FILE *
+prefetch_open (const char *path)
+{
+  Prefetch *item;
+
+  if ( by_location == NULL )
+    return fopen (path, "r");
+
+  item = g_hash_table_lookup (by_location, path);
+  if ( item == NULL )
+    return fopen (path, "r");
+
+  g_hash_table_remove (by_location, path);
+
+  /* fmemopen can't handle an empty buffer */
+  if ( item->length == 0 )
+    return fopen (path, "r");
+
+  /* Recorded inputs must describe the contents actually parsed */
+  if ( inputs_enabled ( ) && !input_is_current (&item->snapshot) )
+    return fopen (path, "r");
+
+  return fmemopen (item->contents, item->length, "r");
+}
+
+/* Hand over the contents of a file loaded by other means (see bulkload.c);
+ * prefetch_open will serve it from memory. Takes ownership of 'contents' */
+void
+prefetch_add (const char *path, char *contents, gsize length, const Input *snapshot)
+{
+  Prefetch *item;
+
+  prefetch_init_tables ( );
+
+  item = g_new0 (Prefetch, 1);
+  item->location = g_strdup (path);
+  item->contents = contents;
+  item->length = length;
+  item->snapshot = *snapshot;
+  item->snapshot.path = item->location;
+  item->done = TRUE;
+
+  g_ptr_array_add (items, item);
+  g_hash_table_replace (by_location, item->location, item);
+}
+
+void
+prefetch_release (void)
+{
+  /* Drop queued lookups but wait for the running ones */
+  if ( pool != NULL )
+    {
+      g_thread_pool_free (pool, TRUE, TRUE);
+      pool = NULL;
+    }
+
+  if ( items == NULL )
+    return;
+
+  g_hash_table_destroy (by_location);
+  g_hash_table_destroy (by_name);
+  g_ptr_array_free (items, TRUE);
+  by_location = NULL;
+  by_name = NULL;
+  items = NULL;
+
+  g_cond_clear (&finished);
+  g_mutex_clear (&lock);
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _PREFETCH_H_
+#define _PREFETCH_H_
+
+#include <stdio.h>
+
+#include "inputs.h"
+#include "package.h"
+
+
+/* Search path lookups and file reads for required packages run on a small
+ * I/O thread pool while the resolver is busy elsewhere. The resolver itself
+ * stays single threaded and consumes the results in its usual order. */
+
+void prefetch_requires (Package *pkg, gboolean ignore_uninstalled);
+
+char * prefetch_find (const char *name, unsigned int *path_position);
+FILE * prefetch_open (const char *path);
+void prefetch_add (const char *path, char *contents, gsize length, const Input *snapshot);
+
+void prefetch_release (void);
+
+
+#endif  /* _PREFETCH_H_ */
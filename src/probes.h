@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _PROBES_H_
+#define _PROBES_H_
+
+
+/* USDT (statically defined tracing) probes of the "pkgconfig" provider for
+ * bpftrace, perf, SystemTap and friends. They are compiled in only when
+ * configured with --enable-usdt; a probe is then a single nop until a
+ * tracer attaches to it. Otherwise the macros expand to nothing and their
+ * arguments are never evaluated. See contrib/bpftrace for examples.
+ *
+ *   package__create__start (name)
+ *   package__create__done  (name, path, found)
+ *   parse__start           (path)
+ *   parse__done            (path, bytes, lines)
+ *   lookup                 (name, dirs probed, path)
+ *   version__test          (version, comparison, required version, result)
+ *   output                 (kind, bytes)
+ *   cache__hit             (bytes)
+ *
+ * Strings may be NULL: path is NULL when nothing was found, or when
+ * package__create__done reports that the -uninstalled variant (which has
+ * probes of its own) was taken instead. */
+
+#if ENABLE_USDT
+
+#include <sys/sdt.h>
+
+#define probe1(name, a)             DTRACE_PROBE1 (pkgconfig, name, a)
+#define probe2(name, a, b)          DTRACE_PROBE2 (pkgconfig, name, a, b)
+#define probe3(name, a, b, c)       DTRACE_PROBE3 (pkgconfig, name, a, b, c)
+#define probe4(name, a, b, c, d)    DTRACE_PROBE4 (pkgconfig, name, a, b, c, d)
+
+#else
+
+#define probe1(name, a)             do { if (0) { (void) (a); } } while (0)
+#define probe2(name, a, b)          do { if (0) { (void) (a); (void) (b); } } while (0)
+#define probe3(name, a, b, c)       do { if (0) { (void) (a); (void) (b); (void) (c); } } while (0)
+#define probe4(name, a, b, c, d)    do { if (0) { (void) (a); (void) (b); (void) (c); (void) (d); } } while (0)
+
+#endif
+
+
+#endif  /* _PROBES_H_ */
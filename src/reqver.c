@@ -17,8 +17,11 @@
  * 02111-1307, USA.
  */
 
+#include <string.h>
+
 #include "reqver.h"
 #include "globals.h"
+#include "probes.h"
 #include "strutil.h"
 #include "utils.h"
 
@@ -30,18 +33,45 @@
 void
 required_version_free (RequiredVersion *rv)
 {
-  g_free (rv->name);
-  g_free (rv->version);
+  /* The strings live in the same block */
   g_free (rv);
 }
 
+/* Name and version are copied into storage allocated along with the item;
+ * 'version' may be NULL */
 RequiredVersion *
-required_version_create (Package *owner)
+required_version_new (Package *owner,
+                      const char *name, gsize name_len,
+                      ComparisonType comparison,
+                      const char *version, gsize version_len)
 {
   RequiredVersion *ver;
+  char *storage;
+  gsize size;
+
+  size = sizeof (RequiredVersion) + name_len + 1;
+  if ( version != NULL )
+    size += version_len + 1;
+
+  ver = g_malloc (size);
+  storage = (char *) (ver + 1);
 
-  ver = g_new0 (RequiredVersion, 1);
   ver->owner = owner;
+  ver->comparison = comparison;
+
+  ver->name = storage;
+  memcpy (storage, name, name_len);
+  storage[name_len] = '\0';
+
+  ver->version = NULL;
+  if ( version != NULL )
+    {
+      storage += name_len + 1;
+      ver->version = storage;
+      memcpy (storage, version, version_len);
+      storage[version_len] = '\0';
+    }
+
   return ver;
 }
 
@@ -100,35 +130,49 @@ version_test (ComparisonType comparison,
               const char *a,
               const char *b)
 {
+  gboolean result = FALSE;
+
   switch (comparison)
     {
     case LESS_THAN:
-      return compare_versions (a, b) < 0;
+      result = compare_versions (a, b) < 0;
+      break;
 
     case GREATER_THAN:
-      return compare_versions (a, b) > 0;
+      result = compare_versions (a, b) > 0;
+      break;
 
     case LESS_THAN_EQUAL:
-      return compare_versions (a, b) <= 0;
+      result = compare_versions (a, b) <= 0;
+      break;
 
     case GREATER_THAN_EQUAL:
-      return compare_versions (a, b) >= 0;
+      result = compare_versions (a, b) >= 0;
+      break;
 
     case EQUAL:
-      return compare_versions (a, b) == 0;
+      result = compare_versions (a, b) == 0;
+      break;
 
     case NOT_EQUAL:
-      return compare_versions (a, b) != 0;
+      result = compare_versions (a, b) != 0;
+      break;
 
     case ALWAYS_MATCH:
-      return TRUE;
+      result = TRUE;
+      break;
 
     case UNKNOWN:
-      return FALSE;
+      result = FALSE;
+      break;
+
+    default:
+      g_assert_not_reached ();
     }
 
-  g_assert_not_reached ();
-  return FALSE;
+  probe4 (version__test, a, comparison_to_str (comparison), b, result);
+
+  return result;
 }
 
 void
@@ -140,130 +184,47 @@ required_versions_add (Package *pkg, RequiredVersion *ver)
   g_hash_table_insert (pkg->required_versions, ver->name, ver);
 }
 
-/* ATTN: Returns FALSE when succeded; TRUE means die */
-gboolean
-required_version_parse (RequiredVersion *ver, const char *value, const char* path)
+/* 'value' is not NUL terminated; 'len' characters are examined */
+ComparisonType
+parse_comparison_type (const char *value, gsize len)
 {
-  char *start, *end;
-
-  end = s_module_sep (value);
-
-  /* name */
-  start = end;
-  end = s_not_space (end);
-  end = scut_module_sep (end);
-
-  if (*start == '\0')
-    {
-      verbose_error ("Empty package name in Requires or Conflicts in file '%s'\n", path);
-      return parse_strict;
-    }
-
-  ver->name = g_strdup (start);
-
-  /* comparator */
-  start = end;
-  end = s_not_space (end);
-  end = scut_space (end);
-
-  ver->comparison = parse_comparison_type (start);
-  if ( ver->comparison == UNKNOWN )
+  switch (len)
     {
-      verbose_error ("Unknown version comparison operator '%s' after "
-                     "package name '%s' in file '%s'\n", start,
-                     ver->name, path);
+    case 0:
+      return ALWAYS_MATCH;
 
-      return parse_strict;
-    }
-
-  /* comparison */
-  start = end;
-  end = s_not_module_sep (end);
-  end = scut_module_sep (end);
-
-  if ( *start == '\0' )
-    {
-      if ( ver->comparison != ALWAYS_MATCH )
+    case 1:
+      switch (value[0])
         {
-          verbose_error ("Comparison operator but no version after package "
-                         "name '%s' in file '%s'\n", ver->name, path);
+        case '=':
+          return EQUAL;
 
-          if ( parse_strict )
-            return TRUE;
+        case '>':
+          return GREATER_THAN;
 
-          ver->version = g_strdup ("0");
-          return FALSE;
+        case '<':
+          return LESS_THAN;
         }
-    }
-  else
-    {
-      ver->version = g_strdup (start);
-    }
 
-  g_assert (ver->name != NULL );
+      return UNKNOWN;
 
-  return FALSE;
-}
-
-ComparisonType
-parse_comparison_type (const char *value)
-{
-  char c;
-
-  c = *value;
-
-  /* empty string? */
-  if (c == '\0')
-    return ALWAYS_MATCH;
-
-  /* '=' */
-  if (c == '=')
-    {
-      c = *++value;
-      return c == '\0' ? EQUAL : UNKNOWN;
-    }
-
-  /* '>' or '>=' */
-  if (c == '>')
-    {
-      /* '>' */
-      c = *++value;
-      if (c == '\0')
-        return GREATER_THAN;
-
-      /* '>=' */
-      if (c != '=')
+    case 2:
+      if ( value[1] != '=' )
         return UNKNOWN;
 
-      c = *++value;
-      return c == '\0' ? GREATER_THAN_EQUAL : UNKNOWN;
-    }
-
-  /* '<' or '<=' */
-  if (c == '<')
-    {
-      /* '<' */
-      c = *++value;
-      if (c == '\0')
-        return LESS_THAN;
-
-      /* '<=' */
-      if (c != '=')
-        return UNKNOWN;
+      switch (value[0])
+        {
+        case '>':
+          return GREATER_THAN_EQUAL;
 
-      c = *++value;
-      return c == '\0' ? LESS_THAN_EQUAL : UNKNOWN;
-    }
+        case '<':
+          return LESS_THAN_EQUAL;
 
-  /* '!=' */
-  if (c == '!')
-    {
-      c = *++value;
-      if (c != '=')
-        return UNKNOWN;
+        case '!':
+          return NOT_EQUAL;
+        }
 
-      c = *++value;
-      return c == '\0' ? NOT_EQUAL : UNKNOWN;
+      return UNKNOWN;
     }
 
   return UNKNOWN;
@@ -45,7 +45,10 @@ typedef struct
 
 
 void required_version_free (RequiredVersion *rv);
-RequiredVersion * required_version_create (Package *owner);
+RequiredVersion * required_version_new (Package *owner,
+                                         const char *name, gsize name_len,
+                                         ComparisonType comparison,
+                                         const char *version, gsize version_len);
 
 #if GLIB_CHECK_VERSION(2,28,0)
   #define required_version_free_list(l)   g_list_free_full ((l), (GDestroyNotify) required_version_free)
@@ -61,8 +64,7 @@ const char *comparison_to_str (ComparisonType comparison);
 
 void required_versions_add (Package *pkg, RequiredVersion *ver);
 
-gboolean required_version_parse (RequiredVersion *ver, const char *value, const char* path);
-ComparisonType parse_comparison_type (const char *value);
+ComparisonType parse_comparison_type (const char *value, gsize len);
 
 
 #endif  /* _REQUIRE_VERSION_H_ */
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef G_OS_WIN32
+#include <sys/resource.h>
+#endif
+
+#include "stats.h"
+#include "utils.h"
+
+
+#define STATS_DEPTH   64
+
+static const char *phase_names[STATS_PHASES] = {
+  "startup",
+  "config",
+  "lookup",
+  "read",
+  "parse",
+  "expand",
+  "resolve",
+  "verify",
+  "output",
+  "other"
+};
+
+static const char *counter_names[STATS_COUNTERS] = {
+  "files_opened",
+  "stat_calls",
+  "lines_parsed",
+  "variables_expanded",
+  "packages_loaded",
+  "flags_created",
+  "flags_deduplicated",
+  "lookups"
+};
+
+/* Counters may be bumped by the prefetch threads */
+static gint counters[STATS_COUNTERS];
+
+static gint64 wall[STATS_PHASES];     /* microseconds */
+static clock_t cpu[STATS_PHASES];
+
+/* Phases entered on the main thread; the bottom one is STATS_OTHER */
+static StatsPhase stack[STATS_DEPTH];
+static guint depth = 0;
+static guint overflow = 0;
+
+static GThread *main_thread = NULL;
+static gint64 last_wall;
+static clock_t last_cpu;
+
+
+/*
+ * Code
+ */
+
+/* Charge the time since the last switch to the current phase */
+static void
+stats_charge (void)
+{
+  gint64 now_wall;
+  clock_t now_cpu;
+
+  now_wall = g_get_monotonic_time ( );
+  now_cpu = clock ( );
+
+  wall[stack[depth - 1]] += now_wall - last_wall;
+  cpu[stack[depth - 1]] += now_cpu - last_cpu;
+
+  last_wall = now_wall;
+  last_cpu = now_cpu;
+}
+
+/* Start collecting; does nothing when already started */
+void
+stats_start (void)
+{
+  if ( depth > 0 )
+    return;
+
+  want_stats = TRUE;
+  main_thread = g_thread_self ( );
+
+  last_wall = g_get_monotonic_time ( );
+  last_cpu = clock ( );
+
+  stack[depth++] = STATS_OTHER;
+  stack[depth++] = STATS_STARTUP;
+}
+
+/* Statistics are switched on before anything else runs so the startup and
+ * the pkg-config package load are covered too; the option itself is
+ * checked later by stats_opt_cb */
+void
+stats_begin (int argc, char **argv)
+{
+  int i;
+
+  for ( i = 1; i < argc; i++ )
+    {
+      if ( strcmp (argv[i], "--") == 0 )
+        break;
+
+      if ( strcmp (argv[i], "--stats") == 0 || strncmp (argv[i], "--stats=", 8) == 0 )
+        {
+          stats_start ( );
+          break;
+        }
+    }
+}
+
+void
+stats_add (StatsCounter counter, guint n)
+{
+  g_atomic_int_add (&counters[counter], n);
+}
+
+void
+stats_push (StatsPhase phase)
+{
+  if ( depth == 0 || g_thread_self ( ) != main_thread )
+    return;
+
+  if ( depth == STATS_DEPTH )
+    {
+      overflow++;
+      return;
+    }
+
+  stats_charge ( );
+  stack[depth++] = phase;
+}
+
+void
+stats_pop (void)
+{
+  if ( depth == 0 || g_thread_self ( ) != main_thread )
+    return;
+
+  if ( overflow > 0 )
+    {
+      overflow--;
+      return;
+    }
+
+  /* Never pop STATS_OTHER */
+  if ( depth == 1 )
+    return;
+
+  stats_charge ( );
+  depth--;
+}
+
+static long
+stats_peak_rss (void)
+{
+#ifndef G_OS_WIN32
+  struct rusage usage;
+
+  /* kilobytes on Linux and the BSDs, bytes on macOS */
+  if ( getrusage (RUSAGE_SELF, &usage) == 0 )
+    {
+#ifdef __APPLE__
+      return usage.ru_maxrss / 1024;
+#else
+      return usage.ru_maxrss;
+#endif
+    }
+#endif
+
+  return -1;
+}
+
+#define WALL_MS(p)  (wall[p] / 1000.0)
+#define CPU_MS(p)   (cpu[p] * 1000.0 / CLOCKS_PER_SEC)
+
+/* Print the statistics to stderr */
+void
+stats_report (void)
+{
+  gint64 total_wall = 0;
+  clock_t total_cpu = 0;
+  const char *name;
+  char label[32];
+  int i, j;
+
+  if ( !want_stats || depth == 0 )
+    return;
+
+  stats_charge ( );
+
+  for ( i = 0; i < STATS_PHASES; i++ )
+    {
+      total_wall += wall[i];
+      total_cpu += cpu[i];
+    }
+
+  spew_flush ( );
+
+  if ( stats_json )
+    {
+      fprintf (stderr, "{\"phases\":{");
+
+      for ( i = 0; i < STATS_PHASES; i++ )
+        fprintf (stderr, "%s\"%s\":{\"wall_ms\":%.3f,\"cpu_ms\":%.3f}", i > 0 ? "," : "",
+                 phase_names[i], WALL_MS (i), CPU_MS (i));
+
+      fprintf (stderr, "},\"total\":{\"wall_ms\":%.3f,\"cpu_ms\":%.3f},\"counters\":{",
+               total_wall / 1000.0, total_cpu * 1000.0 / CLOCKS_PER_SEC);
+
+      for ( i = 0; i < STATS_COUNTERS; i++ )
+        fprintf (stderr, "\"%s\":%d,", counter_names[i], g_atomic_int_get (&counters[i]));
+
+      fprintf (stderr, "\"peak_rss_kib\":%ld}}\n", stats_peak_rss ( ));
+      return;
+    }
+
+  fprintf (stderr, "%-20s %10s %10s\n", "phase", "wall ms", "cpu ms");
+
+  for ( i = 0; i < STATS_PHASES; i++ )
+    fprintf (stderr, "%-20s %10.3f %10.3f\n", phase_names[i], WALL_MS (i), CPU_MS (i));
+
+  fprintf (stderr, "%-20s %10.3f %10.3f\n\n", "total",
+           total_wall / 1000.0, total_cpu * 1000.0 / CLOCKS_PER_SEC);
+
+  fprintf (stderr, "%-20s %10s\n", "counter", "value");
+
+  for ( i = 0; i < STATS_COUNTERS; i++ )
+    {
+      /* files_opened -> files opened */
+      name = counter_names[i];
+      for ( j = 0; name[j] != '\0' && j < (int) sizeof (label) - 1; j++ )
+        label[j] = name[j] == '_' ? ' ' : name[j];
+      label[j] = '\0';
+
+      fprintf (stderr, "%-20s %10d\n", label, g_atomic_int_get (&counters[i]));
+    }
+
+  fprintf (stderr, "%-20s %10ld\n", "peak rss kib", stats_peak_rss ( ));
+}
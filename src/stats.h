@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <glib.h>
+#include "globals.h"
+
+
+/* Phase timers and counters reported by --stats. Time is charged to the
+ * innermost phase entered on the main thread, so the phases add up to the
+ * run time of the process. */
+
+typedef enum
+{
+  STATS_STARTUP,        /* until the command line has been handled */
+  STATS_CONFIG,         /* loading the pkg-config package */
+  STATS_LOOKUP,         /* search path lookups */
+  STATS_READ,           /* opening and reading .pc files */
+  STATS_PARSE,
+  STATS_EXPAND,         /* variable expansion */
+  STATS_RESOLVE,
+  STATS_VERIFY,
+  STATS_OUTPUT,
+  STATS_OTHER,
+  STATS_PHASES
+} StatsPhase;
+
+typedef enum
+{
+  STATS_FILES_OPENED,
+  STATS_STAT_CALLS,
+  STATS_LINES_PARSED,
+  STATS_VARIABLES_EXPANDED,
+  STATS_PACKAGES_LOADED,
+  STATS_FLAGS_CREATED,
+  STATS_FLAGS_DEDUPLICATED,
+  STATS_LOOKUPS,        /* package and variable table lookups */
+  STATS_COUNTERS
+} StatsCounter;
+
+
+/* The flag is tested first, so a disabled hook costs one branch */
+#define stats_count(c)        do { if (want_stats) stats_add ((c), 1); } while (0)
+#define stats_count_n(c, n)   do { if (want_stats) stats_add ((c), (n)); } while (0)
+#define stats_enter(p)        do { if (want_stats) stats_push (p); } while (0)
+#define stats_leave()         do { if (want_stats) stats_pop ( ); } while (0)
+
+void stats_begin (int argc, char **argv);
+void stats_start (void);
+void stats_add (StatsCounter counter, guint n);
+void stats_push (StatsPhase phase);
+void stats_pop (void);
+void stats_report (void);
+
+
+#endif  /* _STATS_H_ */
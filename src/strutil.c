@@ -21,6 +21,7 @@
 #include <string.h>
 
 #include "strutil.h"
+#include "charclass.h"
 #include "parse.h"
 
 
@@ -271,51 +272,73 @@ ends_in_dotpc (const char *str)
 char *
 s_dup_escape_shell (const char *str)
 {
-  size_t len;
-  char *val, *p;
-  char c;
-  unsigned int used;
-
-  len = strlen (str) + 10;
-  p = val = g_malloc (len);
-  used = 0;
-
-  for ( c = *str; c != '\0' ; c = *++str )
-  {
-    if ((c < '$') ||
-        (c > '$' && c < '(') ||
-        (c > ')' && c < '+') ||
-        (c > ':' && c < '=') ||
-        (c > '=' && c < '@') ||
-        (c > 'Z' && c < '^') ||
-        (c == '`') ||
-        (c > 'z' && c < '~') ||
-        (c > '~'))
-      {
-        *p++ = '\\';
-        used++;
-      }
-
-    *p++ = c;
-    used++;
-
-    /* 3 because one character for '\0' + 2 possible characters
-     * in next iteration */
-    if ( used + 3 >= len )
-      {
-        /* Double the buffer */
-        len *= 2;
-
-        /* Reallocate the memory and don't forget to set 'p' pointer */
-        val = g_realloc(val, len);
-        p = val + used;
-      }
-  }
-
-  *p = '\0';
+  GString *val;
+  const char *p;
+
+  p = cc_find_escape (str);
+
+  /* Nothing to escape, just copy it */
+  if ( *p == '\0' )
+    return g_strndup (str, p - str);
+
+  val = g_string_sized_new (strlen (str) + 10);
+
+  /* Copy the runs between the characters that need a '\' in one go */
+  for ( ; *p != '\0'; p = cc_find_escape (str) )
+    {
+      g_string_append_len (val, str, p - str);
+      g_string_append_c (val, '\\');
+      g_string_append_c (val, *p);
+
+      str = p + 1;
+    }
+
+  g_string_append_len (val, str, p - str);
+
+  return g_string_free (val, FALSE);
+}
+
+/* Same as s_dup_escape_shell but takes ownership of 'str' and returns it
+ * as it is when there's nothing to escape */
+char *
+s_escape_shell (char *str)
+{
+  char *val;
+
+  if ( *cc_find_escape (str) == '\0' )
+    return str;
+
+  val = s_dup_escape_shell (str);
+  g_free (str);
+
   return val;
 }
 
+/* Append 'str' to 'json' as a quoted JSON string. Bytes above 0x7f are
+ * copied as they are, so UTF-8 stays UTF-8 */
+void
+s_append_json (GString *json, const char *str)
+{
+  const unsigned char *p;
+
+  g_string_append_c (json, '"');
+
+  for ( p = (const unsigned char *) str; *p != '\0'; p++ )
+    {
+      if ( *p == '"' || *p == '\\' )
+        {
+          g_string_append_c (json, '\\');
+          g_string_append_c (json, *p);
+        }
+      else if ( *p < 0x20 )
+        g_string_append_printf (json, "\\u%04x", *p);
+      else
+        g_string_append_c (json, *p);
+    }
+
+  g_string_append_c (json, '"');
+}
+
 /**
  * Read an entire line from a file into a buffer. Lines may
  * be delimited with '\n', '\r', '\n\r', or '\r\n'. The delimiter
@@ -447,12 +470,7 @@ s_module_sep (const char *p)
 char *
 s_not_module_sep (const char *p)
 {
-  char c;
-
-  for ( c = *p; c != '\0' && !MODULE_SEPARATOR (c); c = *++p )
-    ; /* Nop */
-
-  return (char*)p;
+  return (char*)cc_find_module_sep (p);
 }
 
 char *
@@ -469,12 +487,7 @@ scut_module_sep (char *p)
 char *
 s_space (const char *p)
 {
-  char c;
-
-  for ( c = *p; c != '\0' && IS_SPACE (c); c = *++p )
-    ; /* Nop */
-
-  return (char*)p;
+  return (char*)cc_skip_space (p);
 }
 
 char *
@@ -502,23 +515,13 @@ scut_not_space_equal (char *p)
 char *
 s_end_bracket (const char *p)
 {
-  char c;
-
-  for ( c = *p; c != '\0' && c != '}'; c = *++p )
-    ; /* Nop */
-
-  return (char*)p;
+  return (char*)cc_find_end_bracket (p);
 }
 
 char *
 s_not_space (const char *p)
 {
-  char c;
-
-  for ( c = *p; c != '\0' && !IS_SPACE (c); c = *++p )
-    ; /* Nop */
-
-  return (char*)p;
+  return (char*)cc_find_space (p);
 }
 
 char *
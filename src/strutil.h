@@ -63,6 +63,9 @@ char * s_end_bracket (const char *p);
 
 char * s_trim (const char *str);
 char * s_dup_escape_shell (const char *str);
+char * s_escape_shell (char *str);
+
+void s_append_json (GString *json, const char *str);
 
 
 #endif  /* _STRUTIL_H_ */
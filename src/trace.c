@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef G_OS_WIN32
+#include <unistd.h>
+#endif
+
+#include "trace.h"
+#include "strutil.h"
+#include "utils.h"
+
+
+typedef struct
+{
+  const char *category;         /* static string */
+  char *name;
+  gint64 start;                 /* microseconds */
+  GString *args;                /* NULL when there are none */
+} TraceSpan;
+
+static FILE *trace_out = NULL;
+
+/* Open spans, innermost last */
+static GArray *spans = NULL;
+
+/* Finished spans as Chrome trace "complete" events */
+static GString *events = NULL;
+
+static long trace_pid = 0;
+
+
+/*
+ * Code
+ */
+
+static void
+trace_event_start (const char *ph, const char *category, const char *name)
+{
+  if ( events->len > 0 )
+    g_string_append (events, ",\n");
+
+  g_string_append (events, "{\"name\":");
+  s_append_json (events, name);
+  g_string_append_printf (events, ",\"cat\":\"%s\",\"ph\":\"%s\",\"pid\":%ld,\"tid\":%ld",
+                          category, ph, trace_pid, trace_pid);
+}
+
+/* Start recording; the spans are written to 'path' by trace_finish.
+ * ATTN: Returns FALSE when the file can't be created */
+gboolean
+trace_start (const char *path)
+{
+  if ( want_trace )
+    return TRUE;
+
+  trace_out = fopen (path, "w");
+  if ( trace_out == NULL )
+    {
+      spew ("Cannot open trace file '%s': %s\n", path, g_strerror (errno));
+      return FALSE;
+    }
+
+#ifndef G_OS_WIN32
+  trace_pid = (long) getpid ( );
+#endif
+
+  spans = g_array_new (FALSE, FALSE, sizeof (TraceSpan));
+  events = g_string_new (NULL);
+
+  trace_event_start ("M", "__metadata", "process_name");
+  g_string_append (events, ",\"args\":{\"name\":\"pkg-config\"}}");
+
+  want_trace = TRUE;
+
+  /* Everything from here to the end of the run */
+  trace_push ("query", "pkg-config");
+
+  return TRUE;
+}
+
+void
+trace_push (const char *category, const char *name)
+{
+  TraceSpan span;
+
+  span.category = category;
+  span.name = g_strdup (name);
+  span.args = NULL;
+  span.start = g_get_monotonic_time ( );
+
+  g_array_append_val (spans, span);
+}
+
+void
+trace_pop (void)
+{
+  TraceSpan *span;
+  gint64 now;
+
+  if ( spans->len == 0 )
+    return;
+
+  now = g_get_monotonic_time ( );
+  span = &g_array_index (spans, TraceSpan, spans->len - 1);
+
+  trace_event_start ("X", span->category, span->name);
+  g_string_append_printf (events, ",\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT,
+                          span->start, now - span->start);
+
+  if ( span->args != NULL )
+    {
+      g_string_append (events, ",\"args\":{");
+      g_string_append_len (events, span->args->str, span->args->len);
+      g_string_append_c (events, '}');
+      g_string_free (span->args, TRUE);
+    }
+
+  g_string_append_c (events, '}');
+
+  g_free (span->name);
+  g_array_set_size (spans, spans->len - 1);
+}
+
+static GString *
+trace_args (const char *key)
+{
+  TraceSpan *span;
+
+  span = &g_array_index (spans, TraceSpan, spans->len - 1);
+
+  if ( span->args == NULL )
+    span->args = g_string_new (NULL);
+  else
+    g_string_append_c (span->args, ',');
+
+  s_append_json (span->args, key);
+  g_string_append_c (span->args, ':');
+
+  return span->args;
+}
+
+void
+trace_add_arg (const char *key, const char *value)
+{
+  GString *args;
+
+  if ( spans->len == 0 )
+    return;
+
+  args = trace_args (key);
+
+  s_append_json (args, value != NULL ? value : "");
+}
+
+void
+trace_add_arg_int (const char *key, gint64 value)
+{
+  if ( spans->len == 0 )
+    return;
+
+  g_string_append_printf (trace_args (key), "%" G_GINT64_FORMAT, value);
+}
+
+/* Close the spans still open and write the trace file */
+void
+trace_finish (void)
+{
+  if ( !want_trace )
+    return;
+
+  while ( spans->len > 0 )
+    trace_pop ( );
+
+  fprintf (trace_out, "{\"traceEvents\":[\n%s\n],\"displayTimeUnit\":\"ms\"}\n", events->str);
+  fclose (trace_out);
+
+  g_string_free (events, TRUE);
+  g_array_free (spans, TRUE);
+
+  trace_out = NULL;
+  events = NULL;
+  spans = NULL;
+  want_trace = FALSE;
+}
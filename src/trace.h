@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <glib.h>
+#include "globals.h"
+
+
+/* --trace writes the spans below as Chrome trace events (JSON), which can
+ * be opened in Perfetto or chrome://tracing. Spans are entered and left on
+ * the main thread only and must nest; an argument is attached to the
+ * innermost open span. */
+
+#define trace_enter(cat, name)    do { if (want_trace) trace_push ((cat), (name)); } while (0)
+#define trace_leave()             do { if (want_trace) trace_pop ( ); } while (0)
+#define trace_arg(key, value)     do { if (want_trace) trace_add_arg ((key), (value)); } while (0)
+#define trace_arg_int(key, value) do { if (want_trace) trace_add_arg_int ((key), (value)); } while (0)
+
+gboolean trace_start (const char *path);
+void trace_push (const char *category, const char *name);
+void trace_pop (void);
+void trace_add_arg (const char *key, const char *value);
+void trace_add_arg_int (const char *key, gint64 value);
+void trace_finish (void);
+
+
+#endif  /* _TRACE_H_ */
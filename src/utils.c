@@ -17,11 +17,25 @@
  * 02111-1307, USA.
  */
 
+#include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "utils.h"
+#include "bulkload.h"
+#include "cache.h"
+#include "capture.h"
+#include "depfile.h"
 #include "globals.h"
+#include "graph.h"
+#include "inputs.h"
+#include "journal.h"
 #include "package.h"
+#include "prefetch.h"
+#include "probes.h"
+#include "stats.h"
+#include "trace.h"
+#include "varmap.h"
 
 
 /*
@@ -55,26 +69,15 @@ define_global_variable (const char *varname,
   return TRUE;
 }
 
-/* List of flag pointers */
-GList *
+/* Array of Flag items */
+GArray *
 fill_list (GList *packages, FlagType type,
            gboolean in_path_order, gboolean include_private)
 {
-  GList *iter;
-  GList *expanded = NULL;
-  GList *flags;
-  GHashTable *visited;
+  GList *expanded;
+  GArray *flags;
 
-  /* Start from the end of the requested package list to maintain order since
-   * the recursive list is built by prepending. */
-  visited = g_hash_table_new (g_str_hash, g_str_equal);
-
-  for (iter = g_list_last (packages); iter != NULL; iter = iter->prev )
-    {
-      recursive_fill_list (iter->data, include_private, visited, &expanded);
-    }
-
-  g_hash_table_destroy (visited);
+  expanded = graph_order (packages, include_private);
   package_spew_list ("post-recurse", expanded);
 
   if (in_path_order)
@@ -111,49 +114,6 @@ packages_sort_by_path_position (GList *list)
   return g_list_sort (list, pathposcmp);
 }
 
-/* Construct a topological sort of all required packages.
- *
- * This is a depth first search starting from the right.  The output 'listp' is
- * in reverse order, with the first node reached in the depth first search at
- * the end of the list.  Previously visited nodes are skipped.  The result is
- * a list of packages such that each packages is listed once and comes before
- * any package that it depends on.
- *
- * listp is a list of package pointers
- */
-void
-recursive_fill_list (Package *pkg, gboolean include_private,
-                     GHashTable *visited, GList **listp)
-{
-  GList *iter;
-
-  /*
-   * If the package has already been visited, then it is already in 'listp' and
-   * we can skip it. Additionally, this allows circular requires loops to be
-   * broken.
-   */
-  if ( g_hash_table_lookup_extended (visited, pkg->key, NULL, NULL) )
-    {
-      debug_spew ("Package %s already in requires chain, skipping\n",
-                  pkg->key);
-      return;
-    }
-
-  /* Record this package in the dependency chain, so add new key to hash table */
-  g_hash_table_replace (visited, pkg->key, pkg->key);
-
-  /* Start from the end of the required package list to maintain order since
-   * the recursive list is built by prepending. */
-  iter = include_private ? pkg->requires_private.items : pkg->requires.items;
-
-  for ( iter = g_list_last (iter); iter != NULL; iter = iter->prev )
-    {
-      recursive_fill_list (iter->data, include_private, visited, listp);
-    }
-
-  *listp = g_list_prepend (*listp, pkg);
-}
-
 char *
 file_build_path (const char *dir, const char *name)
 {
@@ -167,21 +127,52 @@ file_find_in_search_dirs (const char *name, unsigned int *path_position)
   unsigned int position = 0;
   char *location;
 
+  /* Also runs on the prefetch threads, whose time isn't recorded */
+  stats_enter (STATS_LOOKUP);
+
   for ( iter = search_dirs.items; iter != NULL; iter = iter->next )
     {
       position++;
       location = file_build_path ((char *) iter->data, name);
 
+      stats_count (STATS_STAT_CALLS);
       if (g_file_test (location, G_FILE_TEST_IS_REGULAR))
         {
           *path_position = position;
+
+          probe3 (lookup, name, position, location);
+          stats_leave ( );
           return location;
         }
 
       g_free (location);
     }
 
-    return NULL;
+  probe3 (lookup, name, position, NULL);
+  stats_leave ( );
+  return NULL;
+}
+
+/*
+ * Use a copy of dirname cause Win32 opendir doesn't like
+ * superfluous trailing (back)slashes in the directory name.
+ */
+char *
+file_strip_dir_separator (const char *dirname)
+{
+  unsigned int length;
+  char *tmpname;
+
+  tmpname = g_strdup (dirname);
+  length = strlen (tmpname);
+
+  if (length != 0 && tmpname [length - 1] == G_DIR_SEPARATOR)
+    {
+      length--;
+      tmpname [length] = '\0';
+    }
+
+  return tmpname;
 }
 
 void
@@ -193,14 +184,36 @@ release ( void )
   if ( packages != NULL )
     package_free_hash_table (packages );
 
+  prefetch_release ( );
+  graph_release ( );
+  var_map_release ( );
+
   free_list (search_dirs.items);
   free_list (cflag_system_dirs.items);
   free_list (lib_system_dirs.items);
+  free_list (requested_variables);
+
+  inputs_release ( );
 }
 
 void
 die (int status)
 {
+  char *output;
+  gsize length;
+
+  /* don't keep stdout captured, but don't cache a failed query either */
+  output = capture_finish (&length);
+  cache_end (status, NULL, 0);
+  journal_end (status, output, length);
+  g_free (output);
+
+  /* the inputs of a failed query matter as well */
+  depfile_finish ( );
+
+  /* keep what has been traced so far */
+  trace_finish ( );
+
   /* release allocated memory */
   release ( );
 
@@ -219,6 +232,9 @@ scan_dirs (Package *pkg_config)
 
   initted = TRUE;
 
+  /* Read all the files up front, scan_file parses them from memory */
+  bulk_load_dirs (search_dirs.items);
+
   for ( iter = search_dirs.items; iter != NULL; iter = iter->next )
     {
       if ( !scan_dir ((char *) iter->data, pkg_config) )
@@ -236,22 +252,10 @@ scan_dir (const char *dirname, Package *pkg_config)
 {
   GDir *dir;
   const gchar *filename;
-  unsigned int length;
   char *tmpname;
   gboolean result = TRUE;
 
-  /*
-   * Use a copy of dirname cause Win32 opendir doesn't like
-   * superfluous trailing (back)slashes in the directory name.
-   */
-  tmpname = g_strdup (dirname);
-  length = strlen (tmpname);
-
-  if (length != 0 && tmpname [length - 1] == G_DIR_SEPARATOR)
-    {
-      length--;
-      tmpname [length] = '\0';
-    }
+  tmpname = file_strip_dir_separator (dirname);
 
 #ifdef G_OS_WIN32
   /* Turn backslashes into slashes or
@@ -269,6 +273,8 @@ scan_dir (const char *dirname, Package *pkg_config)
       goto quit;
     }
 
+  inputs_note_dir (tmpname);
+
   debug_spew ("Scanning directory '%s'\n", tmpname);
   for ( ;; )
     {
@@ -373,25 +379,73 @@ add_search_dirs (const char *path, const char *separator, const char *source)
   g_strfreev (split_dirs);
 }
 
+/* Debug output to stderr is collected here and written in large blocks;
+ * anything else written to stderr flushes it first to keep the order */
+static char spew_buffer[8192];
+static gsize spew_length = 0;
+
+void
+spew_flush (void)
+{
+  if ( spew_length == 0 )
+    return;
+
+  fwrite (spew_buffer, 1, spew_length, stderr);
+  spew_length = 0;
+}
+
 static void
-internal_spew (const char *format, va_list args, gboolean use_stdout)
+spew_buffered (const char *format, va_list args)
 {
-  gchar *str;
-  FILE* stream;
+  static gboolean registered = FALSE;
+  gsize space;
+  va_list copy;
+  int n;
 
-  g_return_if_fail (format != NULL);
+  if ( !registered )
+    {
+      atexit (spew_flush);
+      registered = TRUE;
+    }
 
-  if (use_stdout)
-    stream = stdout;
+  space = sizeof (spew_buffer) - spew_length;
+
+  va_copy (copy, args);
+  n = vsnprintf (spew_buffer + spew_length, space, format, copy);
+  va_end (copy);
+
+  if ( n < 0 )
+    return;
+
+  if ( (gsize) n < space )
+    {
+      spew_length += n;
+      return;
+    }
+
+  /* Didn't fit, try again in an empty buffer */
+  spew_flush ( );
+
+  if ( (gsize) n < sizeof (spew_buffer) )
+    spew_length = vsnprintf (spew_buffer, sizeof (spew_buffer), format, args);
   else
-    stream = stderr;
+    vfprintf (stderr, format, args);
+}
 
-  str = g_strdup_vprintf (format, args);
+static void
+internal_spew (const char *format, va_list args, gboolean use_stdout)
+{
+  if (use_stdout)
+    {
+      vfprintf (stdout, format, args);
+      return;
+    }
 
-  fputs (str, stream);
-  fflush (stream);
+  /* Only stdout is stored so don't cache a diagnosed result */
+  cache_disable ( );
 
-  g_free (str);
+  spew_flush ( );
+  vfprintf (stderr, format, args);
 }
 
 void
@@ -404,45 +458,32 @@ spew (const char *format, ...)
   va_end (args);
 }
 
+/* Called through the debug_spew and parse_spew macros */
 void
-debug_spew (const char *format, ...)
+spew_debug (const char *format, ...)
 {
   va_list args;
 
-  if (!want_debug_spew)
-    return;
-
   va_start (args, format);
-  internal_spew (format, args, want_stdout_errors);
-  va_end (args);
-}
 
-void
-verbose_error (const char *format, ...)
-{
-  va_list args;
-
-  if (!want_verbose_errors)
-    return;
+  if (want_stdout_errors)
+    vfprintf (stdout, format, args);
+  else
+    {
+      cache_disable ( );
+      spew_buffered (format, args);
+    }
 
-  va_start (args, format);
-  internal_spew (format, args, want_stdout_errors);
   va_end (args);
 }
 
-#if HAVE_PARSE_SPEW
-
+/* Called through the verbose_error macro */
 void
-parse_spew (const char *format, ...)
+spew_error (const char *format, ...)
 {
   va_list args;
 
-  if (!want_parse_spew)
-    return;
-
   va_start (args, format);
   internal_spew (format, args, want_stdout_errors);
   va_end (args);
 }
-
-#endif  /* HAVE_PARSE_SPEW */
@@ -22,6 +22,7 @@
 
 #include "package.h"
 #include "flag.h"
+#include "globals.h"
 
 
 typedef enum
@@ -41,13 +42,12 @@ typedef struct
 
 gboolean define_global_variable (const char *varname, const char *varval);
 
-GList * fill_list (GList *packages, FlagType type, gboolean in_path_order, gboolean include_private);
+GArray * fill_list (GList *packages, FlagType type, gboolean in_path_order, gboolean include_private);
 GList * packages_sort_by_path_position (GList *list);
 
-void recursive_fill_list (Package *pkg, gboolean include_private, GHashTable *visited, GList **listp);
-
 char * file_build_path (const char *dir, const char *name);
 char * file_find_in_search_dirs ( const char *name, unsigned int *path_position );
+char * file_strip_dir_separator (const char *dirname);
 
 void release (void);
 void die (int status);
@@ -61,14 +61,25 @@ gboolean init_pc_path ();
 void add_search_dir (const char *path, const char *source);
 void add_search_dirs (const char *path, const char *separator, const char *source);
 
-#if HAVE_PARSE_SPEW
-  void parse_spew (const char *format, ...);
+void spew (const char *format, ...);
+void spew_debug (const char *format, ...);
+void spew_error (const char *format, ...);
+void spew_flush (void);
+
+/* The flag is tested before any argument is evaluated. Debug and parse
+ * spew are compiled out by configure --disable-debug-spew; the calls are
+ * still type checked. */
+#define verbose_error(...)  do { if (want_verbose_errors) spew_error (__VA_ARGS__); } while (0)
+
+#if ENABLE_DEBUG_SPEW
+  #define debug_spew(...)   do { if (want_debug_spew) spew_debug (__VA_ARGS__); } while (0)
+#else
+  #define debug_spew(...)   do { if (0) spew_debug (__VA_ARGS__); } while (0)
 #endif
 
-void spew (const char *format, ...);
-void debug_spew (const char *format, ...);
-void verbose_error (const char *format, ...);
-void verbose_warn (const char *format, ...);
+#if HAVE_PARSE_SPEW
+  #define parse_spew(...)   do { if (want_parse_spew) spew_debug (__VA_ARGS__); } while (0)
+#endif
 
 
 #endif  /* _UTILS_H_ */
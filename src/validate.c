@@ -0,0 +1,411 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifndef G_OS_WIN32
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+#include "validate.h"
+#include "bulkload.h"
+#include "cache.h"
+#include "globals.h"
+#include "strutil.h"
+#include "utils.h"
+
+
+/* The package tables, the graph and the parser state are global, so a
+ * file is validated in a child forked from this process once every file
+ * has been read into memory; up to one child per processor runs at a
+ * time. Each child reports through a pipe and its exit status. */
+
+typedef struct
+{
+  char *path;
+  GString *diagnostics;
+  int status;
+} Validation;
+
+typedef struct
+{
+  Validation *item;
+  pid_t pid;
+  int fd;
+} Worker;
+
+
+/*
+ * Code
+ */
+
+static void
+validation_free (Validation *item)
+{
+  g_free (item->path);
+  g_string_free (item->diagnostics, TRUE);
+  g_free (item);
+}
+
+static void
+validate_add (GPtrArray *items, GHashTable *seen, const char *path)
+{
+  Validation *item;
+
+  if ( g_hash_table_lookup (seen, path) != NULL )
+    return;
+
+  item = g_new0 (Validation, 1);
+  item->path = g_strdup (path);
+  item->diagnostics = g_string_new (NULL);
+
+  g_ptr_array_add (items, item);
+  g_hash_table_insert (seen, item->path, item);
+}
+
+/* Add the .pc files of a directory, silently skipping one that's missing
+ * like the search path does */
+static void
+validate_add_dir (GPtrArray *items, GHashTable *seen, const char *dirname)
+{
+  GDir *dir;
+  const gchar *filename;
+  char *tmpname;
+  char *path;
+
+  tmpname = file_strip_dir_separator (dirname);
+
+  dir = g_dir_open (tmpname, 0, NULL);
+  if ( dir == NULL )
+    {
+      debug_spew ("Cannot open directory '%s' to validate: %s\n",
+                  tmpname, g_strerror (errno));
+      g_free (tmpname);
+      return;
+    }
+
+  while ( (filename = g_dir_read_name (dir)) != NULL )
+    {
+      if ( !ends_in_dotpc (filename) )
+        continue;
+
+      path = g_build_filename (tmpname, filename, NULL);
+      validate_add (items, seen, path);
+      g_free (path);
+    }
+
+  g_dir_close (dir);
+  g_free (tmpname);
+}
+
+static int
+validate_compare (gconstpointer a, gconstpointer b)
+{
+  const Validation *item_a = *(const Validation * const *) a;
+  const Validation *item_b = *(const Validation * const *) b;
+
+  return strcmp (item_a->path, item_b->path);
+}
+
+#ifndef G_OS_WIN32
+
+/* Load the file with its requirements in the child; the verification of
+ * every package loaded covers their versions and Conflicts */
+static void
+validate_child (Package *pkg_config, const char *path, int fd)
+{
+  Package *pkg;
+  gboolean die;
+  int null;
+
+  null = open ("/dev/null", O_RDONLY);
+  if ( null >= 0 )
+    {
+      dup2 (null, STDIN_FILENO);
+      close (null);
+    }
+
+  dup2 (fd, STDOUT_FILENO);
+  dup2 (fd, STDERR_FILENO);
+  close (fd);
+
+  pkg = package_get (pkg_config, path, TRUE, disable_uninstalled, &die);
+
+  fflush (stdout);
+  spew_flush ( );
+  fflush (stderr);
+
+  /* Skip the exit handlers of the parent */
+  _exit (pkg == NULL);
+}
+
+static gboolean
+validate_start (Package *pkg_config, Worker *worker, Validation *item)
+{
+  int fds[2];
+
+  if ( pipe (fds) != 0 )
+    return FALSE;
+
+  fflush (stdout);
+  spew_flush ( );
+  fflush (stderr);
+
+  worker->pid = fork ( );
+  if ( worker->pid < 0 )
+    {
+      close (fds[0]);
+      close (fds[1]);
+      return FALSE;
+    }
+
+  if ( worker->pid == 0 )
+    {
+      close (fds[0]);
+      validate_child (pkg_config, item->path, fds[1]);
+    }
+
+  close (fds[1]);
+
+  worker->item = item;
+  worker->fd = fds[0];
+
+  return TRUE;
+}
+
+/* The child closed its end of the pipe; collect its status */
+static void
+validate_finish (Worker *worker)
+{
+  int status;
+
+  close (worker->fd);
+
+  while ( waitpid (worker->pid, &status, 0) < 0 )
+    {
+      if ( errno != EINTR )
+        {
+          status = -1;
+          break;
+        }
+    }
+
+  if ( status != -1 && WIFEXITED (status) )
+    worker->item->status = WEXITSTATUS (status);
+  else
+    {
+      g_string_append (worker->item->diagnostics, "Validation did not complete\n");
+      worker->item->status = 1;
+    }
+
+  worker->item = NULL;
+}
+
+static gboolean
+validate_run (Package *pkg_config, GPtrArray *items)
+{
+  Worker *workers;
+  struct pollfd *fds;
+  char buf[4096];
+  gssize n;
+  guint jobs;
+  guint running = 0;
+  guint next = 0;
+  guint i;
+
+  jobs = MAX (1, MIN (g_get_num_processors ( ), items->len));
+  workers = g_new0 (Worker, jobs);
+  fds = g_new0 (struct pollfd, jobs);
+
+  while ( next < items->len || running > 0 )
+    {
+      for ( i = 0; i < jobs && next < items->len; i++ )
+        {
+          if ( workers[i].item != NULL )
+            continue;
+
+          if ( !validate_start (pkg_config, &workers[i], g_ptr_array_index (items, next)) )
+            {
+              spew ("Cannot start a validation: %s\n", g_strerror (errno));
+              goto fail;
+            }
+
+          next++;
+          running++;
+        }
+
+      for ( i = 0; i < jobs; i++ )
+        {
+          fds[i].fd = workers[i].item != NULL ? workers[i].fd : -1;
+          fds[i].events = POLLIN;
+          fds[i].revents = 0;
+        }
+
+      if ( poll (fds, jobs, -1) < 0 )
+        {
+          if ( errno == EINTR )
+            continue;
+
+          spew ("Cannot wait for the validations: %s\n", g_strerror (errno));
+          goto fail;
+        }
+
+      for ( i = 0; i < jobs; i++ )
+        {
+          if ( fds[i].revents == 0 )
+            continue;
+
+          n = read (workers[i].fd, buf, sizeof (buf));
+          if ( n < 0 && errno == EINTR )
+            continue;
+
+          if ( n > 0 )
+            {
+              g_string_append_len (workers[i].item->diagnostics, buf, n);
+              continue;
+            }
+
+          validate_finish (&workers[i]);
+          running--;
+        }
+    }
+
+  g_free (fds);
+  g_free (workers);
+
+  return TRUE;
+
+fail:
+
+  for ( i = 0; i < jobs; i++ )
+    {
+      if ( workers[i].item != NULL )
+        validate_finish (&workers[i]);
+    }
+
+  g_free (fds);
+  g_free (workers);
+
+  return FALSE;
+}
+
+#else
+
+static gboolean
+validate_run (Package *pkg_config, GPtrArray *items)
+{
+  spew ("--validate --all is not supported on this platform\n");
+  return FALSE;
+}
+
+#endif
+
+/* Print the failures, with their diagnostics indented below, and a count */
+static gboolean
+validate_report (GPtrArray *items)
+{
+  Validation *item;
+  char **lines;
+  guint failed = 0;
+  guint i;
+  guint j;
+
+  for ( i = 0; i < items->len; i++ )
+    {
+      item = g_ptr_array_index (items, i);
+      if ( item->status == 0 )
+        continue;
+
+      failed++;
+      printf ("FAIL %s\n", item->path);
+
+      lines = g_strsplit (item->diagnostics->str, "\n", -1);
+      for ( j = 0; lines[j] != NULL; j++ )
+        {
+          if ( lines[j][0] != '\0' )
+            printf ("  %s\n", lines[j]);
+        }
+
+      g_strfreev (lines);
+    }
+
+  printf ("validated %u files, %u failed\n", items->len, failed);
+
+  return failed == 0;
+}
+
+gboolean
+validate_all (Package *pkg_config, int argc, char **argv)
+{
+  GPtrArray *items;
+  GHashTable *seen;
+  GList *dirs = NULL;
+  GList *iter;
+  gboolean result;
+  int i;
+
+  /* The answer depends on whole directories, which the cache doesn't
+   * track */
+  cache_disable ( );
+
+  /* Unlike --validate of a package, resolve every requirement */
+  enable_requires ( );
+  enable_requires_private ( );
+
+  items = g_ptr_array_new_with_free_func ((GDestroyNotify) validation_free);
+  seen = g_hash_table_new (g_str_hash, g_str_equal);
+
+  /* Arguments are directories, .pc files or package names; without any,
+   * the whole search path */
+  for ( i = 1; i < argc; i++ )
+    {
+      if ( g_file_test (argv[i], G_FILE_TEST_IS_DIR) )
+        dirs = g_list_append (dirs, g_strdup (argv[i]));
+      else
+        validate_add (items, seen, argv[i]);
+    }
+
+  if ( argc <= 1 )
+    {
+      for ( iter = search_dirs.items; iter != NULL; iter = iter->next )
+        dirs = g_list_append (dirs, g_strdup (iter->data));
+    }
+
+  /* Read everything once here; the children parse from memory */
+  bulk_load_dirs (dirs);
+
+  for ( iter = dirs; iter != NULL; iter = iter->next )
+    validate_add_dir (items, seen, iter->data);
+
+  g_ptr_array_sort (items, validate_compare);
+
+  result = validate_run (pkg_config, items) && validate_report (items);
+
+  g_hash_table_destroy (seen);
+  g_ptr_array_free (items, TRUE);
+  free_list (dirs);
+
+  return result;
+}
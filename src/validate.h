@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+#ifndef _VALIDATE_H_
+#define _VALIDATE_H_
+
+#include <glib.h>
+
+#include "package.h"
+
+
+/* --validate --all: check every .pc file of the search path, or of the
+ * directories and files given, in parallel worker processes and print one
+ * report sorted by file name.
+ * ATTN: Returns FALSE when any file fails or the check couldn't be run */
+gboolean validate_all (Package *pkg_config, int argc, char **argv);
+
+
+#endif  /* _VALIDATE_H_ */
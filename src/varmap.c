@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+
+#include <string.h>
+
+#include "varmap.h"
+#include "stats.h"
+
+
+/* Every variable name in use; names like 'prefix' or 'libdir' are shared by
+ * all packages */
+static GHashTable *names = NULL;
+
+
+/*
+ * Code
+ */
+
+static const char *
+var_name_intern (const char *name)
+{
+  char *interned;
+
+  if ( names == NULL )
+    names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  interned = g_hash_table_lookup (names, name);
+  if ( interned == NULL )
+    {
+      interned = g_strdup (name);
+      g_hash_table_add (names, interned);
+    }
+
+  return interned;
+}
+
+static gint
+var_map_find (const VarMap *map, const char *name)
+{
+  guint i;
+  char c;
+
+  if ( map->index != NULL )
+    return GPOINTER_TO_INT (g_hash_table_lookup (map->index, name)) - 1;
+
+  c = *name;
+  for ( i = 0; i < map->len; i++ )
+    {
+      if ( map->vars[i].name[0] == c && strcmp (map->vars[i].name, name) == 0 )
+        return i;
+    }
+
+  return -1;
+}
+
+/* Value of a variable or NULL; owned by the map */
+char *
+var_map_get (const VarMap *map, const char *name)
+{
+  gint i;
+
+  stats_count (STATS_LOOKUPS);
+
+  i = var_map_find (map, name);
+  return i < 0 ? NULL : map->vars[i].value;
+}
+
+/* Define or redefine a variable; takes ownership of 'value' */
+void
+var_map_set (VarMap *map, const char *name, char *value)
+{
+  gint i;
+  guint j;
+
+  i = var_map_find (map, name);
+  if ( i >= 0 )
+    {
+      g_free (map->vars[i].value);
+      map->vars[i].value = value;
+      return;
+    }
+
+  if ( map->len == map->size )
+    {
+      map->size = map->size == 0 ? 8 : map->size * 2;
+      map->vars = g_renew (Var, map->vars, map->size);
+    }
+
+  map->vars[map->len].name = var_name_intern (name);
+  map->vars[map->len].value = value;
+  map->len++;
+
+  if ( map->index != NULL )
+    {
+      g_hash_table_insert (map->index, (gpointer) map->vars[map->len - 1].name,
+                           GUINT_TO_POINTER (map->len));
+    }
+  else if ( map->len > VAR_MAP_SMALL )
+    {
+      map->index = g_hash_table_new (g_str_hash, g_str_equal);
+
+      for ( j = 0; j < map->len; j++ )
+        g_hash_table_insert (map->index, (gpointer) map->vars[j].name, GUINT_TO_POINTER (j + 1));
+    }
+}
+
+void
+var_map_free (VarMap *map)
+{
+  guint i;
+
+  for ( i = 0; i < map->len; i++ )
+    g_free (map->vars[i].value);
+
+  g_free (map->vars);
+
+  if ( map->index != NULL )
+    g_hash_table_destroy (map->index);
+
+  map->vars = NULL;
+  map->index = NULL;
+  map->len = map->size = 0;
+}
+
+/* List of the names sorted by strcmp; the names are owned by the map */
+GList *
+var_map_sorted_names (const VarMap *map)
+{
+  GList *list = NULL;
+  guint i;
+
+  for ( i = 0; i < map->len; i++ )
+    list = g_list_prepend (list, (gpointer) map->vars[i].name);
+
+  return g_list_sort (list, (GCompareFunc) g_strcmp0);
+}
+
+void
+var_map_release (void)
+{
+  if ( names == NULL )
+    return;
+
+  g_hash_table_destroy (names);
+  names = NULL;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2001, 2002 Red Hat Inc.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ */
+
+
+#ifndef _VARMAP_H_
+#define _VARMAP_H_
+
+#include <glib.h>
+
+
+/* Up to this many variables are looked up by a linear scan */
+#define VAR_MAP_SMALL  16
+
+typedef struct
+{
+  const char *name;   /* interned, see var_map_release */
+  char *value;
+} Var;
+
+/* The variables of a package: a plain array of name/value pairs in the
+ * order they were defined, plus a hash index once there are more than
+ * VAR_MAP_SMALL of them */
+typedef struct
+{
+  Var *vars;
+  guint len;
+  guint size;
+  GHashTable *index;  /* name to position + 1 */
+} VarMap;
+
+
+char * var_map_get (const VarMap *map, const char *name);
+void var_map_set (VarMap *map, const char *name, char *value);
+void var_map_free (VarMap *map);
+GList * var_map_sorted_names (const VarMap *map);
+
+void var_map_release (void);
+
+
+#endif  /* _VARMAP_H_ */